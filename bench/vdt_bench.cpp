@@ -0,0 +1,387 @@
+// vdt_bench: reproducible numbers for the decode, seek, display and save paths.
+// Generates its own synthetic clips (fixed seed) with cv::VideoWriter so runs
+// are comparable across machines and OpenCV / FFmpeg upgrades. Prints JSON.
+//
+//   vdt_bench [--frames N] [--seeks N] [--sizes 640x360,1920x1080]
+//             [--codecs MJPG,mp4v,XVID] [--backend FFMPEG|libavcodec|...]
+//             [--threads N] [--out results.json] [--keep]
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "decodebackend.h"
+#include "displayconvert.h"
+#include "fileutil.h"
+#include "framecache.h"
+#include "videosource.h"
+
+namespace {
+
+struct Options
+{
+    int frames = 120;
+    int seeks = 50;
+    std::vector<cv::Size> sizes{{640, 360}, {1280, 720}, {1920, 1080}};
+    QStringList codecs{"MJPG", "mp4v", "XVID"};
+    DecodeOptions decode;
+    QString out;
+    bool keep = false;
+};
+
+const cv::Size kDisplaySize(1280, 720);     // typical video label size
+const double kFps = 30.0;
+
+QTextStream &err()
+{
+    static QTextStream s(stderr);
+    return s;
+}
+
+double msSince(const QElapsedTimer &t)
+{
+    return t.nsecsElapsed() / 1e6;
+}
+
+QJsonObject latencyStats(std::vector<double> v)
+{
+    QJsonObject o;
+    o["samples"] = static_cast<int>(v.size());
+    if (v.empty()) return o;
+    std::sort(v.begin(), v.end());
+    auto at = [&v](double q) { return v[std::min(v.size() - 1, static_cast<size_t>(q * (v.size() - 1) + 0.5))]; };
+    o["mean"] = std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+    o["p50"] = at(0.50);
+    o["p95"] = at(0.95);
+    o["max"] = v.back();
+    return o;
+}
+
+// Scrolling gradient + moving discs + fixed-seed noise: enough structure and
+// motion that codecs do real work, identical on every run.
+cv::Mat syntheticFrame(cv::Size size, int i, cv::RNG &rng)
+{
+    cv::Mat f(size, CV_8UC3);
+    for (int y = 0; y < size.height; ++y)
+    {
+        uchar *p = f.ptr<uchar>(y);
+        for (int x = 0; x < size.width; ++x)
+        {
+            p[3 * x + 0] = static_cast<uchar>((x + i * 4) & 255);
+            p[3 * x + 1] = static_cast<uchar>((y + i * 2) & 255);
+            p[3 * x + 2] = static_cast<uchar>(((x + y) / 2 + i) & 255);
+        }
+    }
+    for (int k = 0; k < 6; ++k)
+    {
+        const int cx = (k * size.width / 6 + i * (k + 1) * 3) % size.width;
+        const int cy = size.height / 2 + static_cast<int>(std::sin((i + k * 10) * 0.1) * size.height / 3);
+        cv::circle(f, cv::Point(cx, cy), size.height / 10 + k * 4,
+                   cv::Scalar(40 * k, 255 - 30 * k, 128), cv::FILLED, cv::LINE_AA);
+    }
+    cv::Mat noise(size, CV_8UC3);
+    rng.fill(noise, cv::RNG::UNIFORM, 0, 24);
+    f += noise;
+    return f;
+}
+
+bool generateClip(const QString &path, const QString &codec, cv::Size size, int frames)
+{
+    const std::string c = codec.toStdString();
+    if (c.size() != 4) return false;
+    const int fourcc = cv::VideoWriter::fourcc(c[0], c[1], c[2], c[3]);
+    cv::VideoWriter writer(path.toStdString(), fourcc, kFps, size);
+    if (!writer.isOpened()) return false;
+
+    cv::RNG rng(12345);
+    for (int i = 0; i < frames; ++i)
+        writer.write(syntheticFrame(size, i, rng));
+    return true;
+}
+
+QString extensionFor(const QString &codec)
+{
+    return (codec == "mp4v" || codec == "avc1") ? ".mp4" : ".avi";
+}
+
+QJsonObject benchClip(const QString &path, int seeks, const DecodeOptions &decode)
+{
+    QJsonObject o;
+
+    // Sequential decode
+    {
+        VideoSource source;
+        source.setOptions(decode);
+        if (!source.open(path))
+        {
+            o["error"] = "cannot open with " + backendName(decode.api);
+            return o;
+        }
+        o["backend"] = source.backendName();
+        DecodedFrame frame;
+        int n = 0;
+        QElapsedTimer t;
+        t.start();
+        while (source.readNext(frame)) ++n;
+        const double ms = msSince(t);
+        o["decoded_frames"] = n;
+        o["decode_fps"] = ms > 0.0 ? n * 1000.0 / ms : 0.0;
+    }
+
+    const VideoTimeline timeline = VideoTimeline::scan(path, nullptr, decode);
+    if (timeline.frameCount() < 2) return o;
+
+    VideoSource source;
+    source.setOptions(decode);
+    if (!source.open(path)) return o;
+    source.setTimeline(timeline);
+    DecodedFrame frame;
+
+    // Random seeks (slider scrubbing)
+    {
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> pick(0, timeline.frameCount() - 1);
+        std::vector<double> lat;
+        for (int i = 0; i < seeks; ++i)
+        {
+            QElapsedTimer t;
+            t.start();
+            source.seekToIndex(pick(gen), frame);
+            lat.push_back(msSince(t));
+        }
+        o["seek_ms"] = latencyStats(lat);
+    }
+
+    // Step back one frame at a time from the end (Left arrow) the way the app
+    // does: through a FrameCache filled by playing up to there. Steps that
+    // leave the cache fall back to a seek, which is also reported on its own.
+    const int last = timeline.frameCount() - 1;
+    const int steps = std::min(seeks, last);
+    {
+        FrameCache cache;
+        for (int i = 0; i <= last; ++i)
+            if (!cache.fetch(source, i, frame)) break;
+        std::vector<double> lat;
+        for (int i = 0; i < steps; ++i)
+        {
+            QElapsedTimer t;
+            t.start();
+            cache.fetch(source, last - 1 - i, frame);
+            lat.push_back(msSince(t));
+        }
+        o["step_back_ms"] = latencyStats(lat);
+    }
+    {
+        std::vector<double> lat;
+        for (int i = 0; i < steps; ++i)
+        {
+            QElapsedTimer t;
+            t.start();
+            source.seekToIndex(last - 1 - i, frame);
+            lat.push_back(msSince(t));
+        }
+        o["step_back_seek_ms"] = latencyStats(lat);
+    }
+    return o;
+}
+
+QJsonObject benchDisplay(const cv::Mat &frame)
+{
+    std::vector<double> convert, scale, fused;
+    QImage direct;
+    const QSize shownSize = fitInside(QSize(frame.cols, frame.rows), QSize(kDisplaySize.width, kDisplaySize.height));
+    for (int i = 0; i < 30; ++i)
+    {
+        QElapsedTimer t;
+        t.start();
+        const QImage img = matToQImage(frame);
+        convert.push_back(msSince(t));
+
+        t.restart();
+        const QImage shown = img.scaled(kDisplaySize.width, kDisplaySize.height,
+                                        Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        scale.push_back(msSince(t));
+        if (shown.isNull()) break;
+
+        // What the app does now: resize, then one conversion at display size
+        t.restart();
+        const bool ok = matToDisplayImage(frame, shownSize, direct);
+        fused.push_back(msSince(t));
+        if (!ok) break;
+    }
+
+    QJsonObject o;
+    o["width"] = frame.cols;
+    o["height"] = frame.rows;
+    o["convert_ms"] = latencyStats(convert);
+    o["scale_ms"] = latencyStats(scale);
+    o["display_size_ms"] = latencyStats(fused);
+    return o;
+}
+
+QJsonArray benchSave(const cv::Mat &frame, const QDir &dir)
+{
+    QJsonArray out;
+    for (const char *ext : {".png", ".jpg", ".bmp", ".webp"})
+    {
+        std::vector<double> lat;
+        double bytes = 0.0;
+        try
+        {
+            for (int i = 0; i < 20; ++i)
+            {
+                std::vector<uchar> buf;
+                QElapsedTimer t;
+                t.start();
+                cv::imencode(ext, frame, buf);
+                writeFileBytes(dir.filePath(QString("save_%1%2").arg(i).arg(ext)),
+                               reinterpret_cast<const char*>(buf.data()), static_cast<qint64>(buf.size()));
+                lat.push_back(msSince(t));
+                bytes += static_cast<double>(buf.size());
+            }
+        }
+        catch (const cv::Exception &)
+        {
+            continue;   // encoder not built into this OpenCV
+        }
+
+        const double totalMs = std::accumulate(lat.begin(), lat.end(), 0.0);
+        QJsonObject o;
+        o["width"] = frame.cols;
+        o["height"] = frame.rows;
+        o["format"] = QString::fromLatin1(ext);
+        o["ms"] = latencyStats(lat);
+        o["images_per_s"] = totalMs > 0.0 ? lat.size() * 1000.0 / totalMs : 0.0;
+        o["mb_per_s"] = totalMs > 0.0 ? (bytes / (1024.0 * 1024.0)) * 1000.0 / totalMs : 0.0;
+        out.append(o);
+    }
+    return out;
+}
+
+bool parseArgs(const QStringList &args, Options &opt)
+{
+    for (int i = 1; i < args.size(); ++i)
+    {
+        const QString &a = args[i];
+        const bool hasValue = i + 1 < args.size();
+        if (a == "--frames" && hasValue) opt.frames = std::max(2, args[++i].toInt());
+        else if (a == "--seeks" && hasValue) opt.seeks = std::max(1, args[++i].toInt());
+        else if (a == "--codecs" && hasValue) opt.codecs = args[++i].split(',', Qt::SkipEmptyParts);
+        else if (a == "--out" && hasValue) opt.out = args[++i];
+        else if (a == "--keep") opt.keep = true;
+        else if (a == "--threads" && hasValue) opt.decode.threads = std::max(0, args[++i].toInt());
+        else if (a == "--backend" && hasValue)
+        {
+            opt.decode.api = backendFromName(args[++i]);
+            if (opt.decode.api < 0)
+            {
+                err() << "unknown or unavailable backend " << args[i] << "\n";
+                return false;
+            }
+        }
+        else if (a == "--sizes" && hasValue)
+        {
+            opt.sizes.clear();
+            for (const QString &s : args[++i].split(',', Qt::SkipEmptyParts))
+            {
+                const QStringList wh = s.split('x');
+                if (wh.size() == 2 && wh[0].toInt() > 0 && wh[1].toInt() > 0)
+                    opt.sizes.emplace_back(wh[0].toInt(), wh[1].toInt());
+            }
+        }
+        else
+        {
+            err() << "usage: vdt_bench [--frames N] [--seeks N] [--sizes WxH,...] "
+                     "[--codecs MJPG,mp4v,...] [--backend NAME] [--threads N] "
+                     "[--out file.json] [--keep]\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    Options opt;
+    if (!parseArgs(app.arguments(), opt)) return 2;
+
+    QTemporaryDir tmp;
+    if (!tmp.isValid())
+    {
+        err() << "cannot create a temporary directory\n";
+        return 1;
+    }
+    tmp.setAutoRemove(!opt.keep);
+    const QDir dir(tmp.path());
+
+    QJsonObject root;
+    root["opencv"] = QString::fromLatin1(CV_VERSION);
+    root["threads"] = cv::getNumThreads();
+    root["frames"] = opt.frames;
+    root["decode_threads"] = opt.decode.threads;
+
+    QJsonArray clips, display, save;
+    for (const cv::Size &size : opt.sizes)
+    {
+        cv::RNG rng(12345);
+        const cv::Mat sample = syntheticFrame(size, 0, rng);
+        display.append(benchDisplay(sample));
+        for (const QJsonValue &v : benchSave(sample, dir)) save.append(v);
+
+        for (const QString &codec : opt.codecs)
+        {
+            const QString path = dir.filePath(QString("clip_%1x%2_%3%4")
+                                                  .arg(size.width).arg(size.height)
+                                                  .arg(codec, extensionFor(codec)));
+            err() << "generating " << QFileInfo(path).fileName() << "\n";
+            err().flush();
+
+            QJsonObject clip;
+            clip["codec"] = codec;
+            clip["width"] = size.width;
+            clip["height"] = size.height;
+            if (!generateClip(path, codec, size, opt.frames))
+            {
+                clip["error"] = "writer unavailable";
+                clips.append(clip);
+                continue;
+            }
+            const QJsonObject r = benchClip(path, opt.seeks, opt.decode);
+            for (auto it = r.begin(); it != r.end(); ++it) clip[it.key()] = it.value();
+            clips.append(clip);
+        }
+    }
+    root["clips"] = clips;
+    root["display"] = display;
+    root["save"] = save;
+
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    QTextStream(stdout) << json;
+    if (!opt.out.isEmpty() && !writeFileBytes(opt.out, json.constData(), json.size()))
+    {
+        err() << "cannot write " << opt.out << "\n";
+        return 1;
+    }
+    if (opt.keep) err() << "clips kept in " << tmp.path() << "\n";
+    return 0;
+}
@@ -0,0 +1,280 @@
+#include "annotations.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+
+int AnnotationSet::addTrack(const QString &label)
+{
+    const int id = nextId_++;
+    tracks_[id].label = label;
+    return id;
+}
+
+void AnnotationSet::setKey(int track, int frame, const cv::Rect2d &box)
+{
+    auto it = tracks_.find(track);
+    if (it == tracks_.end()) return;
+    it->second.keys[frame] = box;
+    it->second.tracked.erase(frame);
+}
+
+void AnnotationSet::setTrackedKey(int track, int frame, const cv::Rect2d &box)
+{
+    auto it = tracks_.find(track);
+    if (it == tracks_.end()) return;
+    it->second.keys[frame] = box;
+    it->second.tracked.insert(frame);
+}
+
+bool AnnotationSet::removeKey(int track, int frame)
+{
+    auto it = tracks_.find(track);
+    if (it == tracks_.end() || it->second.keys.erase(frame) == 0) return false;
+    it->second.tracked.erase(frame);
+    if (it->second.keys.empty()) tracks_.erase(it);
+    return true;
+}
+
+void AnnotationSet::removeTrack(int track)
+{
+    tracks_.erase(track);
+}
+
+bool AnnotationSet::hasKey(int track, int frame) const
+{
+    auto it = tracks_.find(track);
+    return it != tracks_.end() && it->second.keys.count(frame) != 0;
+}
+
+bool AnnotationSet::hasDrawnKey(int track, int frame) const
+{
+    auto it = tracks_.find(track);
+    return it != tracks_.end() && it->second.keys.count(frame) != 0 && it->second.tracked.count(frame) == 0;
+}
+
+bool AnnotationSet::isPointTrack(int track) const
+{
+    auto it = tracks_.find(track);
+    if (it == tracks_.end() || it->second.keys.empty()) return false;
+    const cv::Rect2d &b = it->second.keys.begin()->second;
+    return b.width <= 0.0 && b.height <= 0.0;
+}
+
+QString AnnotationSet::labelOf(int track) const
+{
+    auto it = tracks_.find(track);
+    return it != tracks_.end() ? it->second.label : QString();
+}
+
+std::vector<int> AnnotationSet::keyFrames(int track) const
+{
+    std::vector<int> frames;
+    auto it = tracks_.find(track);
+    if (it == tracks_.end()) return frames;
+    for (const auto &k : it->second.keys) frames.push_back(k.first);
+    return frames;
+}
+
+bool AnnotationSet::boxAt(const Track &t, int frame, cv::Rect2d &box, bool &keyframe)
+{
+    // First key after frame, and the one at or before it
+    auto next = t.keys.upper_bound(frame);
+    if (next == t.keys.begin()) return false;
+    auto prev = std::prev(next);
+    keyframe = prev->first == frame;
+    if (keyframe)
+    {
+        box = prev->second;
+        return true;
+    }
+    if (next == t.keys.end()) return false;
+
+    const double f = static_cast<double>(frame - prev->first) / (next->first - prev->first);
+    const cv::Rect2d &a = prev->second;
+    const cv::Rect2d &b = next->second;
+    box = cv::Rect2d(a.x + (b.x - a.x) * f, a.y + (b.y - a.y) * f,
+                     a.width + (b.width - a.width) * f, a.height + (b.height - a.height) * f);
+    return true;
+}
+
+std::vector<Annotation> AnnotationSet::at(int frame) const
+{
+    std::vector<Annotation> out;
+    for (const auto &t : tracks_)
+    {
+        Annotation a;
+        if (!boxAt(t.second, frame, a.box, a.keyframe)) continue;
+        a.track = t.first;
+        a.label = t.second.label;
+        out.push_back(a);
+    }
+    return out;
+}
+
+int AnnotationSet::trackAt(int frame, const cv::Point2d &p, double radius) const
+{
+    int best = 0;
+    double bestArea = 0.0;
+    for (const Annotation &a : at(frame))
+    {
+        double area = a.box.area();
+        if (a.isPoint())
+        {
+            const double dx = p.x - a.box.x, dy = p.y - a.box.y;
+            if (dx * dx + dy * dy > radius * radius) continue;
+            area = 0.0;     // points win over the box they sit in
+        }
+        else if (!a.box.contains(p))
+            continue;
+        if (best == 0 || area < bestArea)
+        {
+            best = a.track;
+            bestArea = area;
+        }
+    }
+    return best;
+}
+
+bool AnnotationSet::save(const QString &file) const
+{
+    QJsonArray tracks;
+    for (const auto &t : tracks_)
+    {
+        QJsonArray keys;
+        for (const auto &k : t.second.keys)
+        {
+            QJsonArray a{k.first, k.second.x, k.second.y, k.second.width, k.second.height};
+            if (t.second.tracked.count(k.first)) a.append(1);      // tracker-placed
+            keys.append(a);
+        }
+        QJsonObject o;
+        o["id"] = t.first;
+        o["label"] = t.second.label;
+        o["keys"] = keys;
+        tracks.append(o);
+    }
+
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(QJsonDocument(QJsonObject{{"tracks", tracks}}).toJson(QJsonDocument::Compact));
+    return f.commit();
+}
+
+bool AnnotationSet::load(const QString &file)
+{
+    clear();
+    nextId_ = 1;
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+
+    const QJsonArray tracks = QJsonDocument::fromJson(f.readAll()).object().value("tracks").toArray();
+    for (const QJsonValue &v : tracks)
+    {
+        const QJsonObject o = v.toObject();
+        const int id = o.value("id").toInt();
+        if (id <= 0) continue;
+        Track &t = tracks_[id];
+        t.label = o.value("label").toString();
+        for (const QJsonValue &k : o.value("keys").toArray())
+        {
+            const QJsonArray a = k.toArray();
+            if (a.size() != 5 && a.size() != 6) continue;
+            t.keys[a[0].toInt()] = cv::Rect2d(a[1].toDouble(), a[2].toDouble(), a[3].toDouble(), a[4].toDouble());
+            if (a.size() == 6 && a[5].toInt() != 0) t.tracked.insert(a[0].toInt());
+        }
+        if (t.keys.empty()) tracks_.erase(id);
+        nextId_ = std::max(nextId_, id + 1);
+    }
+    return true;
+}
+
+std::vector<Annotation> mapAnnotationsToOutput(const std::vector<Annotation> &a, const OutputSettings &s,
+                                               cv::Size frameSize)
+{
+    // Same crop as prepareOutputFrame()
+    const cv::Rect full(0, 0, frameSize.width, frameSize.height);
+    cv::Rect crop = s.roi.empty() ? full : (s.roi & full);
+    if (crop.empty()) crop = full;
+    const cv::Size out = outputSizeFor(s, crop.size());
+    const double sx = static_cast<double>(out.width) / crop.width;
+    const double sy = static_cast<double>(out.height) / crop.height;
+    const cv::Rect2d bounds(0.0, 0.0, out.width, out.height);
+
+    std::vector<Annotation> mapped;
+    for (Annotation m : a)
+    {
+        m.box = cv::Rect2d((m.box.x - crop.x) * sx, (m.box.y - crop.y) * sy, m.box.width * sx, m.box.height * sy);
+        if (m.isPoint())
+        {
+            if (!bounds.contains(m.box.tl())) continue;
+        }
+        else
+        {
+            m.box &= bounds;
+            if (m.box.width < 1.0 || m.box.height < 1.0) continue;
+        }
+        mapped.push_back(m);
+    }
+    return mapped;
+}
+
+QByteArray annotationsToYolo(const std::vector<Annotation> &a, cv::Size imageSize, const QStringList &classes)
+{
+    QByteArray out;
+    if (imageSize.width <= 0 || imageSize.height <= 0) return out;
+    for (const Annotation &m : a)
+    {
+        const int cls = classes.indexOf(m.label);
+        if (cls < 0 || m.isPoint()) continue;
+        out += QString("%1 %2 %3 %4 %5\n").arg(cls)
+                   .arg((m.box.x + m.box.width / 2.0) / imageSize.width, 0, 'f', 6)
+                   .arg((m.box.y + m.box.height / 2.0) / imageSize.height, 0, 'f', 6)
+                   .arg(m.box.width / imageSize.width, 0, 'f', 6)
+                   .arg(m.box.height / imageSize.height, 0, 'f', 6).toUtf8();
+    }
+    return out;
+}
+
+QByteArray annotationsToCoco(const std::vector<Annotation> &a, cv::Size imageSize, const QString &imageName,
+                             const QStringList &classes)
+{
+    QJsonArray categories;
+    for (int i = 0; i < classes.size(); ++i)
+        categories.append(QJsonObject{{"id", i}, {"name", classes[i]}});
+
+    QJsonArray anns;
+    int id = 1;
+    for (const Annotation &m : a)
+    {
+        const int cls = classes.indexOf(m.label);
+        if (cls < 0) continue;
+        QJsonObject o;
+        o["id"] = id++;
+        o["image_id"] = 1;
+        o["category_id"] = cls;
+        o["track_id"] = m.track;
+        o["iscrowd"] = 0;
+        if (m.isPoint())
+        {
+            o["bbox"] = QJsonArray{m.box.x, m.box.y, 0, 0};
+            o["area"] = 0;
+            o["keypoints"] = QJsonArray{m.box.x, m.box.y, 2};
+            o["num_keypoints"] = 1;
+        }
+        else
+        {
+            o["bbox"] = QJsonArray{m.box.x, m.box.y, m.box.width, m.box.height};
+            o["area"] = m.box.area();
+        }
+        anns.append(o);
+    }
+
+    QJsonObject image{{"id", 1}, {"file_name", imageName}, {"width", imageSize.width}, {"height", imageSize.height}};
+    QJsonObject doc{{"images", QJsonArray{image}}, {"annotations", anns}, {"categories", categories}};
+    return QJsonDocument(doc).toJson(QJsonDocument::Compact) + '\n';
+}
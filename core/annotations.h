@@ -0,0 +1,89 @@
+#ifndef ANNOTATIONS_H
+#define ANNOTATIONS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <opencv2/opencv.hpp>
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "frameoutput.h"
+
+// One box (or point: zero size) on one frame, in source frame pixels.
+struct Annotation
+{
+    int track = 0;
+    QString label;
+    cv::Rect2d box;
+    bool keyframe = false;      // placed on this frame, not interpolated
+
+    bool isPoint() const { return box.width <= 0.0 && box.height <= 0.0; }
+};
+
+// Boxes / points of one video. Every object is a track of keyframes; frames
+// between two keyframes get the linearly interpolated box, frames outside
+// the first..last keyframe get none.
+class AnnotationSet
+{
+public:
+    int addTrack(const QString &label);         // id of the new, empty track
+    void setKey(int track, int frame, const cv::Rect2d &box);
+    // Key placed by the object tracker: re-tracking may replace it, a drawn
+    // key is where tracking stops
+    void setTrackedKey(int track, int frame, const cv::Rect2d &box);
+    bool removeKey(int track, int frame);       // the last key takes the track with it
+    void removeTrack(int track);
+    void clear() { tracks_.clear(); }
+
+    bool isEmpty() const { return tracks_.empty(); }
+    bool hasTrack(int track) const { return tracks_.count(track) != 0; }
+    bool hasKey(int track, int frame) const;
+    bool hasDrawnKey(int track, int frame) const;
+    bool isPointTrack(int track) const;
+    QString labelOf(int track) const;
+    std::vector<int> keyFrames(int track) const;
+
+    std::vector<Annotation> at(int frame) const;
+    // Track whose box contains p on frame (smallest first), points within
+    // radius; 0 if none.
+    int trackAt(int frame, const cv::Point2d &p, double radius) const;
+
+    bool save(const QString &file) const;
+    bool load(const QString &file);             // replaces everything
+
+private:
+    struct Track
+    {
+        QString label;
+        std::map<int, cv::Rect2d> keys;         // frame -> box
+        std::set<int> tracked;                  // keys placed by the tracker
+    };
+    static bool boxAt(const Track &t, int frame, cv::Rect2d &box, bool &keyframe);
+
+    std::map<int, Track> tracks_;
+    int nextId_ = 1;
+};
+
+// Export formats written next to a saved image (flags).
+enum AnnotationFormat
+{
+    AnnotationYolo = 1,         // <image>.txt: "class cx cy w h", normalized
+    AnnotationCoco = 2,         // <image>.json: COCO images/annotations/categories for that image
+};
+
+// Maps frame annotations into a saved image: ROI crop, then resize to the
+// output size. Boxes are clipped; what falls outside the crop is dropped.
+std::vector<Annotation> mapAnnotationsToOutput(const std::vector<Annotation> &a, const OutputSettings &s,
+                                               cv::Size frameSize);
+
+// classes gives the class ids (index); unknown labels are skipped. YOLO has
+// no points, so they only appear in COCO (as a one-keypoint annotation).
+QByteArray annotationsToYolo(const std::vector<Annotation> &a, cv::Size imageSize, const QStringList &classes);
+QByteArray annotationsToCoco(const std::vector<Annotation> &a, cv::Size imageSize, const QString &imageName,
+                             const QStringList &classes);
+
+#endif // ANNOTATIONS_H
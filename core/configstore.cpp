@@ -0,0 +1,113 @@
+#include "configstore.h"
+#include "trace.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+
+ConfigStore::ConfigStore()
+{
+    writer_.setMaxThreadCount(1);
+    saveTimer_.setSingleShot(true);
+    saveTimer_.setInterval(kSaveDelayMs);
+    QObject::connect(&saveTimer_, &QTimer::timeout, [this]() {
+        // Snapshot now; the file is written from the copy
+        writer_.start([path = path_, entries = entries_]() {
+            VDT_TRACE_THREAD("config writer");
+            write(path, entries);
+        });
+    });
+}
+
+ConfigStore::~ConfigStore()
+{
+    flush();
+}
+
+bool ConfigStore::load()
+{
+    QFile f(path_);
+    if (!f.exists()) return false;
+    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+
+    entries_.clear();
+    QTextStream in(&f);
+    while (!in.atEnd())
+    {
+        const QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        const int eq = line.indexOf('=');
+        if (eq <= 0) continue;
+
+        setValue(line.left(eq).trimmed(), line.mid(eq + 1).trimmed());
+    }
+    f.close();
+    return true;
+}
+
+bool ConfigStore::save()
+{
+    saveTimer_.stop();
+    writer_.waitForDone();      // an older snapshot must not land after this one
+    return write(path_, entries_);
+}
+
+void ConfigStore::saveLater()
+{
+    saveTimer_.start();         // restarts: bursts of changes become one write
+}
+
+void ConfigStore::flush()
+{
+    if (saveTimer_.isActive()) save();
+    writer_.waitForDone();
+}
+
+bool ConfigStore::write(const QString &path, const Entries &entries)
+{
+    VDT_TRACE_SCOPE("config write");
+    if (path.isEmpty()) return false;
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    QTextStream out(&f);
+    out << "# Simple config for Video Dataset Preparation Tool\n";
+    for (const auto &e : entries)
+        out << e.first << "=" << e.second << "\n";
+    out.flush();
+    return f.commit();
+}
+
+bool ConfigStore::contains(const QString &key) const
+{
+    for (const auto &e : entries_)
+        if (e.first == key) return true;
+    return false;
+}
+
+QString ConfigStore::value(const QString &key, const QString &def) const
+{
+    for (const auto &e : entries_)
+        if (e.first == key) return e.second;
+    return def;
+}
+
+int ConfigStore::intValue(const QString &key, int def) const
+{
+    bool ok = false;
+    const int v = value(key).toInt(&ok);
+    return ok ? v : def;
+}
+
+void ConfigStore::setValue(const QString &key, const QString &value)
+{
+    for (auto &e : entries_)
+    {
+        if (e.first == key)
+        {
+            e.second = value;
+            return;
+        }
+    }
+    entries_.append(qMakePair(key, value));
+}
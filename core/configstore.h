@@ -0,0 +1,51 @@
+#ifndef CONFIGSTORE_H
+#define CONFIGSTORE_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+
+// Flat "key=value" text file (config.txt). Keys keep their insertion order.
+// Writes go to a temporary file renamed over config.txt, so a crash leaves
+// either the old or the new file, never a truncated one.
+class ConfigStore
+{
+public:
+    ConfigStore();
+    ~ConfigStore();             // flushes a pending saveLater()
+
+    ConfigStore(const ConfigStore &) = delete;
+    ConfigStore &operator=(const ConfigStore &) = delete;
+
+    void setPath(const QString &path) { path_ = path; }
+    const QString &path() const { return path_; }
+
+    bool load();                // replaces all values
+    bool save();                // synchronous
+
+    // Debounced: changes within kSaveDelayMs are written once, off the
+    // calling thread (which needs an event loop).
+    void saveLater();
+    void flush();               // writes a pending change now and waits for it
+
+    bool contains(const QString &key) const;
+    QString value(const QString &key, const QString &def = QString()) const;
+    int intValue(const QString &key, int def = 0) const;
+    void setValue(const QString &key, const QString &value);
+    void setValue(const QString &key, int value) { setValue(key, QString::number(value)); }
+
+private:
+    using Entries = QList<QPair<QString, QString>>;
+    static constexpr int kSaveDelayMs = 500;
+
+    static bool write(const QString &path, const Entries &entries);
+
+    QString path_;
+    Entries entries_;
+    QTimer saveTimer_;
+    QThreadPool writer_;        // one thread: writes land in order
+};
+
+#endif // CONFIGSTORE_H
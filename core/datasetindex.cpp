@@ -0,0 +1,358 @@
+#include "datasetindex.h"
+#include "fileutil.h"
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <QThread>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// O_CREAT | O_EXCL: exactly one process creates the file
+bool createExclusive(const QString &path, const QString &token)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly | QIODevice::NewOnly)) return false;
+    f.write(token.toUtf8() + '\n');
+    f.close();
+    return true;
+}
+
+// False if there is no such file; an empty token is a holder between
+// creating and writing it
+bool readToken(const QString &path, QString &token)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    token = QString::fromUtf8(f.readAll().trimmed());
+    return true;
+}
+
+// A lock holder, and how long (by our clock) it has stayed the same
+struct Watch
+{
+    QString token;
+    QElapsedTimer unchanged;
+
+    qint64 observe(const QString &t)
+    {
+        if (!unchanged.isValid() || t != token)
+        {
+            token = t;
+            unchanged.start();
+        }
+        return unchanged.elapsed();
+    }
+};
+
+} // namespace
+
+DatasetIndex::DatasetIndex()
+    : owner_(QString("%1 %2").arg(QSysInfo::machineHostName().remove(' ')).arg(QCoreApplication::applicationPid()))
+{
+}
+
+DatasetIndex::~DatasetIndex()
+{
+    returnLease();
+}
+
+void DatasetIndex::setDirectory(const QString &dir)
+{
+    if (dir != dir_)
+    {
+        returnLease();
+        dir_ = dir;
+        leaseStart_ = leaseEnd_ = 0;
+    }
+    rescan();
+}
+
+void DatasetIndex::rescan()
+{
+    if (pending_ > 0 || hasLease(1)) return;
+    if (dir_.isEmpty())
+    {
+        next_ = 1;
+        return;
+    }
+    const int counter = peekCounter();
+    next_ = counter > 0 ? counter : largestNumberIn(dir_) + 1;
+}
+
+bool DatasetIndex::isWritable() const
+{
+    if (!hasDirectory()) return false;
+    // A directory still to be created is judged by its nearest existing parent
+    QString path = QFileInfo(dir_).absoluteFilePath();
+    while (!QFileInfo::exists(path) && QFileInfo(path).absolutePath() != path)
+        path = QFileInfo(path).absolutePath();
+    const QFileInfo fi(path);
+    return fi.isDir() && fi.isWritable();
+}
+
+int DatasetIndex::reserve(int count)
+{
+    // A burst needs its numbers contiguous; the rest of a short lease is skipped.
+    // No lease, no numbers: local numbering may collide with another process.
+    if (!hasLease(count) && !(hasDirectory() && isWritable() && lease(count)))
+    {
+        leaseStart_ = leaseEnd_ = 0;
+        return -1;
+    }
+
+    const int first = next_;
+    next_ += count;
+    pending_ += count;
+    return first;
+}
+
+void DatasetIndex::release(int count)
+{
+    pending_ = std::max(0, pending_ - count);
+}
+
+QString DatasetIndex::counterPath() const
+{
+    return QDir(dir_).filePath(".vdt_index");
+}
+
+QString DatasetIndex::lockPath() const
+{
+    return QDir(dir_).filePath(".vdt_index.lock");
+}
+
+QString DatasetIndex::breakPath() const
+{
+    return lockPath() + ".break";
+}
+
+bool DatasetIndex::isStale(const QString &holder, qint64 unchangedMs) const
+{
+    if (unchangedMs > kStaleLockMs) return true;
+    // Same machine: the OS knows whether the holder still runs
+    const QStringList parts = holder.split(' ');
+    return parts.size() == 3 && parts[0] == owner_.section(' ', 0, 0) && !processAlive(parts[1].toLongLong());
+}
+
+bool DatasetIndex::lock() const
+{
+    QElapsedTimer waited;
+    waited.start();
+    // Fresh per acquisition: a holder that relocks often never looks unchanged
+    held_ = QString("%1 %2").arg(owner_).arg(QRandomGenerator::global()->generate64(), 0, 16);
+    Watch holder;
+    Watch breaker;
+    while (waited.elapsed() < kLockTimeoutMs)
+    {
+        if (createExclusive(lockPath(), held_)) return true;
+
+        QString current;
+        if (!readToken(lockPath(), current))
+        {
+            // Neither creatable nor there: nothing can lock in this directory
+            if (!QFileInfo(dir_).isDir() || !isWritable()) return false;
+            continue;                           // released in between
+        }
+        if (isStale(current, holder.observe(current)))
+        {
+            if (breakLock(current)) continue;
+            // Another waiter is breaking it, or died doing so (held for microseconds)
+            QString b;
+            if (readToken(breakPath(), b) && isStale(b, breaker.observe(b)))
+                QFile::remove(breakPath());
+        }
+        QThread::msleep(20);
+    }
+    return false;
+}
+
+bool DatasetIndex::breakLock(const QString &holder) const
+{
+    // Under a second lock, and only if the stale holder is still the one in
+    // place: a waiter that saw the same holder must not remove the lock the
+    // first breaker has taken since
+    if (!createExclusive(breakPath(), held_)) return false;
+    QString current;
+    if (readToken(lockPath(), current) && current == holder)
+        QFile::remove(lockPath());
+    QFile::remove(breakPath());
+    return true;
+}
+
+void DatasetIndex::unlock() const
+{
+    // Ours, unless it was broken as stale meanwhile
+    QString holder;
+    if (readToken(lockPath(), holder) && holder == held_)
+        QFile::remove(lockPath());
+}
+
+int DatasetIndex::peekCounter() const
+{
+    QFile f(counterPath());
+    if (!f.open(QIODevice::ReadOnly)) return 0;
+    bool ok = false;
+    const int v = f.readAll().trimmed().toInt(&ok);
+    return ok ? v : 0;
+}
+
+bool DatasetIndex::lease(int count)
+{
+    VDT_TRACE_SCOPE("index lease");
+    if (!lock()) return false;
+
+    // First lease in this directory: continue after what is already there
+    int start = peekCounter();
+    if (start <= 0) start = largestNumberIn(dir_) + 1;
+    const int size = std::max(count, kLeaseBlock);
+
+    // Counter replaced atomically: a crash between write and rename keeps the old value
+    QSaveFile f(counterPath());
+    bool ok = f.open(QIODevice::WriteOnly);
+    ok = ok && f.write(QByteArray::number(start + size) + '\n') > 0 && f.commit();
+    unlock();
+    if (!ok) return false;
+
+    leaseStart_ = start;
+    leaseEnd_ = start + size;
+    next_ = start;
+    return true;
+}
+
+void DatasetIndex::returnLease()
+{
+    if (dir_.isEmpty() || leaseEnd_ <= leaseStart_ || next_ >= leaseEnd_) return;
+    if (!lock()) return;
+
+    // Only if nobody leased after us; otherwise the rest stays a gap
+    if (peekCounter() == leaseEnd_)
+    {
+        QSaveFile f(counterPath());
+        if (f.open(QIODevice::WriteOnly))
+        {
+            f.write(QByteArray::number(std::max(next_, leaseStart_)) + '\n');
+            f.commit();
+        }
+    }
+    unlock();
+    leaseStart_ = leaseEnd_ = 0;
+}
+
+QString DatasetIndex::fileNameFor(int index)
+{
+    // Format: image_XXXX.png (zero-padded to 4 digits)
+    return QString("image_%1.png").arg(index, 4, 10, QLatin1Char('0'));
+}
+QString DatasetIndex::contentFileNameFor(const QByteArray &sha256Hex)
+{
+    const QString hex = QString::fromLatin1(sha256Hex);
+    return QString("%1/%2/%3.png").arg(hex.left(2), hex.mid(2, 2), hex);
+}
+
+QString DatasetIndex::relativePathFor(int index) const
+{
+    if (shardSize_ <= 0) return fileNameFor(index);
+    return QString("%1/%2").arg(index / shardSize_, 4, 10, QLatin1Char('0')).arg(fileNameFor(index));
+}
+
+bool DatasetIndex::mergeClasses(const QString &dirPath, QStringList &classes)
+{
+    DatasetIndex index;
+    index.dir_ = dirPath;                   // no rescan: only the lock is needed
+    if (!index.lock()) return false;
+
+    const QString path = QDir(dirPath).filePath("classes.txt");
+    QStringList merged;
+    QFile in(path);
+    if (in.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        for (const QByteArray &line : in.readAll().split('\n'))
+            if (!line.trimmed().isEmpty()) merged << QString::fromUtf8(line.trimmed());
+        in.close();
+    }
+    const qsizetype known = merged.size();
+    for (const QString &c : classes)
+        if (!merged.contains(c)) merged << c;
+
+    bool ok = true;
+    if (merged.size() != known || !in.exists())
+    {
+        QSaveFile f(path);
+        ok = f.open(QIODevice::WriteOnly) && f.write(merged.join('\n').toUtf8() + '\n') > 0 && f.commit();
+    }
+    index.unlock();
+    if (ok) classes = merged;
+    return ok;
+}
+
+bool DatasetIndex::isShardName(const QString &folder)
+{
+    static const QRegularExpression shardName("^\\d{4,}$");
+    if (!shardName.match(folder).hasMatch()) return false;
+    bool ok = false;
+    const int n = folder.toInt(&ok);
+    return ok && folder == QString("%1").arg(n, 4, 10, QLatin1Char('0'));
+}
+
+int DatasetIndex::largestNumberIn(const QString &dirPath)
+{
+    QDir dir(dirPath);
+    if (!dir.exists()) return 0;
+
+    // Sharded layout: only the highest shard with images can hold the largest
+    // number. Shards are exactly relativePathFor()'s zero-padded names, so
+    // other numeric folders ("2023/", content-hash "37/") are not mistaken
+    // for one.
+    int maxNum = largestNumberInFolder(dirPath);
+    std::vector<std::pair<int, QString>> shards;
+    for (const QString &sub : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        if (isShardName(sub)) shards.emplace_back(sub.toInt(), sub);
+    std::sort(shards.begin(), shards.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+    for (const auto &shard : shards)
+    {
+        // An empty top shard (created, nothing saved yet): try the one below
+        const int inShard = largestNumberInFolder(dir.filePath(shard.second));
+        if (inShard <= 0) continue;
+        maxNum = std::max(maxNum, inShard);
+        break;
+    }
+    return maxNum;
+}
+
+int DatasetIndex::largestNumberInFolder(const QString &dirPath)
+{
+    QDir dir(dirPath);
+    if (!dir.exists()) return 0;
+
+    QStringList filters;
+    filters << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp";
+    QFileInfoList list = dir.entryInfoList(filters, QDir::Files | QDir::NoSymLinks | QDir::Readable);
+
+    int maxNum = 0;
+    QRegularExpression re("(\\d+)");
+    for (const QFileInfo &fi : list)
+    {
+        const QString base = fi.completeBaseName(); // without extension
+        QRegularExpressionMatchIterator it = re.globalMatch(base);
+        while (it.hasNext())
+        {
+            QRegularExpressionMatch m = it.next();
+            bool ok = false;
+            int num = m.captured(1).toInt(&ok);
+            if (ok) maxNum = std::max(maxNum, num);
+        }
+    }
+    return maxNum;
+}
@@ -0,0 +1,98 @@
+#ifndef DATASETINDEX_H
+#define DATASETINDEX_H
+
+#include <QString>
+#include <QStringList>
+
+// Numbering of saved images (image_XXXX.png) inside one save directory.
+// Indices are reserved before a save starts and released once it is on disk,
+// so concurrent / asynchronous saves never get the same number.
+//
+// Several processes (annotators on a shared / NFS directory) may save into the
+// same directory: numbers are leased from a counter file (.vdt_index) in
+// blocks of kLeaseBlock under a lock file created exclusively
+// (.vdt_index.lock), so the directory is scanned once when the counter is
+// created and never again. The lock holds its owner's "host pid nonce": a
+// holder on this machine is stale once its process is gone, one elsewhere
+// once the lock has not changed for kStaleLockMs by the waiter's own clock
+// (file times are the server's and not comparable). Breaking a stale lock
+// goes through a second lock (.vdt_index.lock.break) and re-checks the owner,
+// so two waiters never both take over.
+class DatasetIndex
+{
+public:
+    static constexpr int kLeaseBlock = 64;
+    static constexpr int kLockTimeoutMs = 5000;
+    static constexpr int kStaleLockMs = 3000;      // held for milliseconds; this long means dead
+
+    DatasetIndex();
+    ~DatasetIndex();                            // hands an unused lease back when possible
+
+    DatasetIndex(const DatasetIndex &) = delete;
+    DatasetIndex &operator=(const DatasetIndex &) = delete;
+
+    void setDirectory(const QString &dir);     // also rescans
+    const QString &directory() const { return dir_; }
+    bool hasDirectory() const { return !dir_.isEmpty(); }
+    bool isWritable() const;                    // checked before saving: reserve() would fail
+
+    int nextIndex() const { return next_; }
+    void setNextIndex(int index) { next_ = index; }
+    int pending() const { return pending_; }
+
+    // Refresh nextIndex() from the shared counter (or the files, if there is
+    // none yet) unless reservations are outstanding or the current lease
+    // still has numbers left.
+    void rescan();
+
+    // First index of the block, or -1 if no lease could be taken (directory
+    // not writable, lock busy): numbering locally could collide with others.
+    int reserve(int count = 1);
+    void release(int count = 1);                // written or abandoned
+    void track(int count) { pending_ += count; }    // in-flight saves that need no number
+
+    // Images per subdirectory, so no folder grows past shardSize entries
+    // ("0012/image_12345.png" for 1000); 0 = everything in the save directory.
+    static constexpr int kDefaultShardSize = 1000;
+    void setShardSize(int size) { shardSize_ = size > 0 ? size : 0; }
+    int shardSize() const { return shardSize_; }
+    QString relativePathFor(int index) const;  // where image index goes, per the layout
+    static bool isShardName(const QString &folder);     // as relativePathFor() names them
+
+    static QString fileNameFor(int index);
+    // Content-addressed name: sharded by the first two hash bytes, so no
+    // directory grows past a few thousand entries and no index is needed.
+    static QString contentFileNameFor(const QByteArray &sha256Hex);
+    static int largestNumberIn(const QString &dirPath);     // flat files and the top non-empty shard
+
+    // Adds the names of classes missing from dirPath/classes.txt to it, under
+    // the index lock since every annotator saving there shares the file;
+    // classes becomes the merged list (ids of existing names never change).
+    static bool mergeClasses(const QString &dirPath, QStringList &classes);
+
+private:
+    static int largestNumberInFolder(const QString &dirPath);
+    bool hasLease(int count) const { return next_ >= leaseStart_ && next_ + count <= leaseEnd_; }
+    bool lease(int count);                      // new block of at least count
+    void returnLease();
+    int peekCounter() const;                    // next unleased index, 0 if unknown
+
+    bool lock() const;
+    void unlock() const;
+    bool breakLock(const QString &holder) const;   // false while another waiter breaks it
+    bool isStale(const QString &holder, qint64 unchangedMs) const;
+    QString counterPath() const;
+    QString lockPath() const;
+    QString breakPath() const;
+
+    const QString owner_;                       // "host pid"
+    mutable QString held_;                      // "host pid nonce" of the lock we hold, per acquisition
+    QString dir_;
+    int next_ = 1;
+    int pending_ = 0;
+    int shardSize_ = 0;
+    int leaseStart_ = 0;                        // [leaseStart_, leaseEnd_) is ours
+    int leaseEnd_ = 0;
+};
+
+#endif // DATASETINDEX_H
@@ -0,0 +1,114 @@
+#include "decodebackend.h"
+#include "framedecoder.h"
+#include "trace.h"
+
+#include <QElapsedTimer>
+
+#include <opencv2/opencv.hpp>
+#include <opencv2/videoio/registry.hpp>
+
+#define VDT_CV_AT_LEAST(major, minor) \
+    (CV_VERSION_MAJOR > (major) || (CV_VERSION_MAJOR == (major) && CV_VERSION_MINOR >= (minor)))
+
+std::vector<int> availableFileBackends()
+{
+    std::vector<int> apis;
+    for (cv::VideoCaptureAPIs api : cv::videoio_registry::getStreamBackends())
+    {
+        // Image-sequence reader would "open" a video path as a pattern
+        if (api == cv::CAP_IMAGES) continue;
+        apis.push_back(static_cast<int>(api));
+    }
+#if defined(VDT_WITH_FFMPEG) && VDT_WITH_FFMPEG
+    apis.push_back(kApiLibav);
+#endif
+    return apis;
+}
+
+QString backendName(int api)
+{
+    if (api == cv::CAP_ANY) return QStringLiteral("Default");
+    if (api == kApiLibav) return QStringLiteral("libavcodec");
+    return QString::fromStdString(cv::videoio_registry::getBackendName(static_cast<cv::VideoCaptureAPIs>(api)));
+}
+
+int backendFromName(const QString &name)
+{
+    if (name.compare("Default", Qt::CaseInsensitive) == 0) return cv::CAP_ANY;
+    for (int api : availableFileBackends())
+        if (backendName(api).compare(name, Qt::CaseInsensitive) == 0) return api;
+    return -1;
+}
+
+bool openCapture(cv::VideoCapture &cap, const QString &path, const DecodeOptions &opt)
+{
+    const std::string file = path.toStdString();
+#if VDT_CV_AT_LEAST(4, 6)
+    std::vector<int> params;
+    if (opt.threads > 0)
+    {
+        params.push_back(cv::CAP_PROP_N_THREADS);
+        params.push_back(opt.threads);
+    }
+    if (opt.hwAccel)
+    {
+        // ANY falls back to software when no device is usable
+        params.push_back(cv::CAP_PROP_HW_ACCELERATION);
+        params.push_back(cv::VIDEO_ACCELERATION_ANY);
+    }
+    return cap.open(file, opt.api, params);
+#else
+    return cap.open(file, opt.api);
+#endif
+}
+
+std::vector<BackendProbe> probeBackends(const QString &path, const DecodeOptions &opt,
+                                        int frames, const std::atomic_bool *cancel)
+{
+    VDT_TRACE_SCOPE("probe backends");
+    std::vector<BackendProbe> probes;
+    for (int api : availableFileBackends())
+    {
+        if (cancel && cancel->load()) break;
+
+        BackendProbe p;
+        p.api = api;
+        p.name = backendName(api);
+
+        DecodeOptions o = opt;
+        o.api = api;
+        std::unique_ptr<FrameDecoder> dec = createDecoder(o);
+        p.opened = dec->open(path, o);
+
+        // First frame pays for codec setup; time the steady state only
+        cv::Mat frame;
+        double pts = 0.0;
+        if (p.opened && dec->grab(pts) && dec->retrieve(frame))
+        {
+            QElapsedTimer t;
+            t.start();
+            int n = 0;
+            while (n < frames && !(cancel && cancel->load()) && dec->grab(pts) && dec->retrieve(frame))
+                ++n;
+            const double s = t.nsecsElapsed() / 1e9;
+            if (n > 0 && s > 0.0) p.decodeFps = n / s;
+        }
+        probes.push_back(p);
+    }
+    return probes;
+}
+
+int fastestBackend(const std::vector<BackendProbe> &probes)
+{
+    int best = cv::CAP_ANY;
+    double bestFps = 0.0;
+    for (const BackendProbe &p : probes)
+    {
+        if (p.decodeFps > bestFps)
+        {
+            bestFps = p.decodeFps;
+            best = p.api;
+        }
+    }
+    return best;
+}
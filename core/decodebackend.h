@@ -0,0 +1,55 @@
+#ifndef DECODEBACKEND_H
+#define DECODEBACKEND_H
+
+#include <QString>
+
+#include <atomic>
+#include <vector>
+
+namespace cv { class VideoCapture; }
+
+// Pseudo API id for the native libavcodec decoder (VDT_WITH_FFMPEG builds);
+// outside the cv::VideoCaptureAPIs range.
+constexpr int kApiLibav = 100000;
+
+// How files are opened with cv::VideoCapture.
+struct DecodeOptions
+{
+    int api = 0;                // cv::VideoCaptureAPIs, 0 = CAP_ANY (OpenCV decides)
+    int threads = 0;            // decoder threads, 0 = backend default
+    bool hwAccel = false;       // ask for hardware decode (VAAPI/D3D11/...) if available
+
+    bool operator==(const DecodeOptions &o) const
+    {
+        return api == o.api && threads == o.threads && hwAccel == o.hwAccel;
+    }
+    bool operator!=(const DecodeOptions &o) const { return !(*this == o); }
+};
+
+// Measured result of one backend against one file.
+struct BackendProbe
+{
+    int api = 0;
+    QString name;
+    bool opened = false;
+    double decodeFps = 0.0;     // 0 when it opened but could not decode
+};
+
+// File (stream) backends compiled into this OpenCV, in registry priority order,
+// plus kApiLibav when built with FFmpeg.
+std::vector<int> availableFileBackends();
+QString backendName(int api);               // "Default" for CAP_ANY
+int backendFromName(const QString &name);   // -1 if unknown or not built in
+
+// cap.open() honouring opt; thread / hw settings need OpenCV >= 4.6 and are
+// ignored on older builds.
+bool openCapture(cv::VideoCapture &cap, const QString &path, const DecodeOptions &opt);
+
+// Opens path with every file backend and times `frames` sequential reads
+// (grab + retrieve, like playback).
+std::vector<BackendProbe> probeBackends(const QString &path, const DecodeOptions &opt,
+                                        int frames, const std::atomic_bool *cancel = nullptr);
+// Fastest backend that decoded anything, or CAP_ANY.
+int fastestBackend(const std::vector<BackendProbe> &probes);
+
+#endif // DECODEBACKEND_H
@@ -0,0 +1,58 @@
+#include "displayconvert.h"
+#include "trace.h"
+
+QImage matToQImage(const cv::Mat &bgr)
+{
+    VDT_TRACE_SCOPE("cvtColor");
+    cv::Mat rgb;
+    if (bgr.channels() == 4)
+    {
+        cv::cvtColor(bgr, rgb, cv::COLOR_BGRA2RGBA);
+        return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGBA8888).copy();
+    }
+
+    if (bgr.channels() == 3)
+        cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+    else
+        cv::cvtColor(bgr, rgb, cv::COLOR_GRAY2RGB);
+
+    return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
+}
+
+QSize fitInside(const QSize &frame, const QSize &area)
+{
+    if (frame.isEmpty() || area.isEmpty()) return QSize();
+    return frame.scaled(area, Qt::KeepAspectRatio);
+}
+
+void prepareDisplayImage(QImage &img, const QSize &size)
+{
+    if (img.size() != size || img.format() != QImage::Format_RGB32 || !img.isDetached())
+        img = QImage(size, QImage::Format_RGB32);
+}
+
+bool matToDisplayImage(const cv::Mat &bgr, const QSize &size, QImage &img)
+{
+    if (bgr.empty() || size.isEmpty()) return false;
+
+    // Display-size scratch, reused frame to frame
+    thread_local cv::Mat scratch;
+    const cv::Size dst(size.width(), size.height());
+    const cv::Mat *small = &bgr;
+    if (dst != bgr.size())
+    {
+        VDT_TRACE_SCOPE("resize");
+        cv::resize(bgr, scratch, dst, 0, 0, dst.area() < bgr.size().area() ? cv::INTER_AREA : cv::INTER_LINEAR);
+        small = &scratch;
+    }
+
+    VDT_TRACE_SCOPE("cvtColor");
+    // Write into the QImage's own buffer (RGB32 is 0xffRRGGBB, i.e. B,G,R,A bytes)
+    prepareDisplayImage(img, size);
+    cv::Mat view(img.height(), img.width(), CV_8UC4, img.bits(), static_cast<size_t>(img.bytesPerLine()));
+    if (small->channels() == 4)
+        small->copyTo(view);
+    else
+        cv::cvtColor(*small, view, small->channels() == 3 ? cv::COLOR_BGR2BGRA : cv::COLOR_GRAY2BGRA);
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef DISPLAYCONVERT_H
+#define DISPLAYCONVERT_H
+
+#include <QImage>
+
+#include <opencv2/opencv.hpp>
+
+// Decoded OpenCV frame (BGR, BGRA or grey) -> QImage that owns its pixels.
+QImage matToQImage(const cv::Mat &bgr);
+
+// Largest size with the frame's aspect ratio that fits into area.
+QSize fitInside(const QSize &frame, const QSize &area);
+
+// Makes img a detached Format_RGB32 image of exactly size, keeping its buffer
+// when it already is one (the display image persists across frames).
+void prepareDisplayImage(QImage &img, const QSize &size);
+
+// Display path: resize to `size` first, then convert once, straight into img
+// (Format_RGB32 is BGRA in memory, so BGR input needs no channel swap).
+bool matToDisplayImage(const cv::Mat &bgr, const QSize &size, QImage &img);
+
+#endif // DISPLAYCONVERT_H
@@ -0,0 +1,308 @@
+#include "ffmpegdecoder.h"
+#include "displayconvert.h"
+#include "trace.h"
+
+#include <QImage>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+#include <cmath>
+
+namespace {
+
+// Same tolerance VideoTimeline::indexAt() uses for "this frame is on screen"
+constexpr double kPtsToleranceMs = 0.5;
+
+// Full-resolution BGR for saving: interpolated chroma, exact rounding
+constexpr int kFullResFlags = SWS_BICUBIC | SWS_ACCURATE_RND | SWS_FULL_CHR_H_INT;
+
+bool isFullRange(const AVFrame *f)
+{
+    switch (f->format)
+    {
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUVJ444P:
+        return true;
+    default:
+        return f->color_range == AVCOL_RANGE_JPEG;
+    }
+}
+
+// YUV matrix of the stream; untagged streams get what players assume
+// (BT.709 from 720p up, BT.601 below)
+int colorMatrix(const AVFrame *f)
+{
+    if (f->colorspace != AVCOL_SPC_UNSPECIFIED && f->colorspace != AVCOL_SPC_RGB)
+        return f->colorspace;
+    return f->height >= 720 ? SWS_CS_ITU709 : SWS_CS_DEFAULT;
+}
+
+// One scale + colour conversion pass (swscale's SIMD kernels) into dst.
+// Display runs on the GUI thread and saves on encoders, so the cached
+// context is per thread.
+bool swsConvert(const AVFrame *src, int w, int h, AVPixelFormat fmt, uint8_t *dst, int stride, int flags)
+{
+    struct Context
+    {
+        SwsContext *sws = nullptr;
+        ~Context() { sws_freeContext(sws); }
+    };
+    thread_local Context ctx;
+
+    ctx.sws = sws_getCachedContext(ctx.sws, src->width, src->height, static_cast<AVPixelFormat>(src->format),
+                                   w, h, fmt, flags, nullptr, nullptr, nullptr);
+    if (!ctx.sws) return false;
+
+    // swscale defaults to BT.601 limited range; set the stream's own (RGB
+    // output is always full range). Per call: a reused context may hold
+    // another stream's.
+    sws_setColorspaceDetails(ctx.sws, sws_getCoefficients(colorMatrix(src)), isFullRange(src) ? 1 : 0,
+                             sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+
+    uint8_t *planes[4] = { dst, nullptr, nullptr, nullptr };
+    int strides[4] = { stride, 0, 0, 0 };
+    sws_scale(ctx.sws, src->data, src->linesize, 0, src->height, planes, strides);
+    return true;
+}
+
+// Holds a reference to the decoder's buffer; nothing is copied.
+class AvPicture : public NativePicture
+{
+public:
+    explicit AvPicture(const AVFrame *src) : frame_(av_frame_clone(src)) {}
+    ~AvPicture() override { av_frame_free(&frame_); }
+
+    bool isValid() const { return frame_ != nullptr; }
+
+    cv::Size size() const override { return cv::Size(frame_->width, frame_->height); }
+
+    size_t byteSize() const override
+    {
+        const int n = av_image_get_buffer_size(static_cast<AVPixelFormat>(frame_->format),
+                                               frame_->width, frame_->height, 1);
+        return n > 0 ? static_cast<size_t>(n) : 0;
+    }
+
+    bool toBgr(cv::Mat &bgr) const override
+    {
+        bgr.create(frame_->height, frame_->width, CV_8UC3);
+        return swsConvert(frame_, bgr.cols, bgr.rows, AV_PIX_FMT_BGR24,
+                          bgr.data, static_cast<int>(bgr.step[0]), kFullResFlags);
+    }
+
+    bool toDisplay(const QSize &size, QImage &rgb32) const override
+    {
+        VDT_TRACE_SCOPE("sws_scale display");
+        // AV_PIX_FMT_RGB32 is native-endian 0xAARRGGBB, the same layout as QImage::Format_RGB32
+        prepareDisplayImage(rgb32, size);
+        const int flags = size.width() < frame_->width ? SWS_AREA : SWS_BILINEAR;
+        return swsConvert(frame_, size.width(), size.height(), AV_PIX_FMT_RGB32,
+                          rgb32.bits(), static_cast<int>(rgb32.bytesPerLine()), flags);
+    }
+
+private:
+    AVFrame *frame_;
+};
+
+} // namespace
+
+FfmpegDecoder::~FfmpegDecoder()
+{
+    close();
+}
+
+bool FfmpegDecoder::open(const QString &path, const DecodeOptions &opt)
+{
+    close();
+
+    if (avformat_open_input(&fmt_, path.toUtf8().constData(), nullptr, nullptr) < 0) return false;
+    if (avformat_find_stream_info(fmt_, nullptr) < 0)
+    {
+        close();
+        return false;
+    }
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 59
+    const AVCodec *dec = nullptr;
+#else
+    AVCodec *dec = nullptr;
+#endif
+    stream_ = av_find_best_stream(fmt_, AVMEDIA_TYPE_VIDEO, -1, -1, &dec, 0);
+    if (stream_ < 0 || !dec)
+    {
+        close();
+        return false;
+    }
+    AVStream *st = fmt_->streams[stream_];
+
+    codec_ = avcodec_alloc_context3(dec);
+    if (!codec_ || avcodec_parameters_to_context(codec_, st->codecpar) < 0)
+    {
+        close();
+        return false;
+    }
+    // Frame + slice threading; 0 = one thread per core
+    codec_->thread_count = opt.threads;
+    codec_->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    if (avcodec_open2(codec_, dec, nullptr) < 0)
+    {
+        close();
+        return false;
+    }
+
+    packet_ = av_packet_alloc();
+    frame_ = av_frame_alloc();
+    if (!packet_ || !frame_)
+    {
+        close();
+        return false;
+    }
+
+    timeBaseMs_ = av_q2d(st->time_base) * 1000.0;
+    startPts_ = st->start_time != AV_NOPTS_VALUE ? st->start_time : 0;
+    const AVRational rate = av_guess_frame_rate(fmt_, st, nullptr);
+    fps_ = (rate.num > 0 && rate.den > 0) ? av_q2d(rate) : 0.0;
+    if (st->nb_frames > 0)
+        frameCount_ = static_cast<int>(st->nb_frames);
+    else if (fmt_->duration != AV_NOPTS_VALUE && fps_ > 0.0)
+        frameCount_ = static_cast<int>(std::lround(fmt_->duration / double(AV_TIME_BASE) * fps_));
+    return true;
+}
+
+void FfmpegDecoder::close()
+{
+    av_frame_free(&frame_);
+    av_packet_free(&packet_);
+    avcodec_free_context(&codec_);
+    avformat_close_input(&fmt_);
+    stream_ = -1;
+    fps_ = 0.0;
+    frameCount_ = 0;
+    draining_ = false;
+    hasFrame_ = false;
+}
+
+cv::Size FfmpegDecoder::frameSize() const
+{
+    return codec_ ? cv::Size(codec_->width, codec_->height) : cv::Size();
+}
+
+QString FfmpegDecoder::codecName() const
+{
+    return codec_ ? QString::fromLatin1(avcodec_get_name(codec_->codec_id)) : QString();
+}
+
+double FfmpegDecoder::ptsOf(const AVFrame *f) const
+{
+    int64_t ts = f->best_effort_timestamp;
+    if (ts == AV_NOPTS_VALUE) ts = f->pts;
+    if (ts == AV_NOPTS_VALUE) return 0.0;
+    return static_cast<double>(ts - startPts_) * timeBaseMs_;
+}
+
+bool FfmpegDecoder::decodeNext()
+{
+    hasFrame_ = false;
+    for (;;)
+    {
+        const int r = avcodec_receive_frame(codec_, frame_);
+        if (r == 0) return hasFrame_ = true;
+        if (r != AVERROR(EAGAIN)) return false;     // drained or broken
+
+        // Feed the next packet of our stream; end of file starts draining
+        int read = 0;
+        while ((read = av_read_frame(fmt_, packet_)) >= 0 && packet_->stream_index != stream_)
+            av_packet_unref(packet_);
+        if (read < 0)
+        {
+            if (draining_) return false;
+            draining_ = true;
+            avcodec_send_packet(codec_, nullptr);
+            continue;
+        }
+        const int sent = avcodec_send_packet(codec_, packet_);
+        av_packet_unref(packet_);
+        if (sent < 0 && sent != AVERROR(EAGAIN)) return false;
+    }
+}
+
+bool FfmpegDecoder::grab(double &ptsMs)
+{
+    if (!isOpen() || !decodeNext()) return false;
+    ptsMs = ptsOf(frame_);
+    return true;
+}
+
+bool FfmpegDecoder::retrieve(cv::Mat &bgr)
+{
+    if (!hasFrame_) return false;
+    VDT_TRACE_SCOPE("sws_scale");
+
+    // No intermediate image: swscale writes the caller's Mat directly
+    bgr.create(frame_->height, frame_->width, CV_8UC3);
+    return swsConvert(frame_, bgr.cols, bgr.rows, AV_PIX_FMT_BGR24,
+                      bgr.data, static_cast<int>(bgr.step[0]), kFullResFlags);
+}
+
+bool FfmpegDecoder::retrieveProxy(const cv::Size &maxSize, cv::Mat &bgr, cv::Size &fullSize)
+{
+    if (!hasFrame_) return false;
+    VDT_TRACE_SCOPE("sws_scale proxy");
+
+    // Scale and convert in one pass; the full-size BGR never exists
+    fullSize = cv::Size(frame_->width, frame_->height);
+    const cv::Size size = proxySizeFor(fullSize, maxSize);
+    bgr.create(size, CV_8UC3);
+    return swsConvert(frame_, size.width, size.height, AV_PIX_FMT_BGR24,
+                      bgr.data, static_cast<int>(bgr.step[0]), size == fullSize ? kFullResFlags : SWS_AREA);
+}
+
+std::shared_ptr<const NativePicture> FfmpegDecoder::retrieveNative()
+{
+    if (!hasFrame_) return nullptr;
+    auto pic = std::make_shared<AvPicture>(frame_);
+    if (!pic->isValid()) return nullptr;
+    return pic;
+}
+
+bool FfmpegDecoder::seekBefore(double targetMs)
+{
+    const int64_t ts = startPts_ + static_cast<int64_t>(std::floor(targetMs / timeBaseMs_));
+    if (av_seek_frame(fmt_, stream_, ts, AVSEEK_FLAG_BACKWARD) < 0) return false;
+    avcodec_flush_buffers(codec_);
+    draining_ = false;
+    hasFrame_ = false;
+    return true;
+}
+
+double FfmpegDecoder::decodeForwardTo(double targetMs)
+{
+    double pts = ptsOf(frame_);
+    while (pts + kPtsToleranceMs < targetMs)
+    {
+        if (!decodeNext()) return -1.0;     // target past the end
+        pts = ptsOf(frame_);
+    }
+    return pts;
+}
+
+double FfmpegDecoder::seekAndGrab(double targetMs)
+{
+    if (!isOpen()) return -1.0;
+    VDT_TRACE_SCOPE("seek");
+
+    // Keyframe at or before the target, then decode forward to the exact frame
+    if (seekBefore(targetMs) && decodeNext() && ptsOf(frame_) <= targetMs + kPtsToleranceMs)
+        return decodeForwardTo(targetMs);
+
+    // A bad index landed past the target: walk from the start instead
+    if (seekBefore(0.0) && decodeNext())
+        return decodeForwardTo(targetMs);
+    return -1.0;
+}
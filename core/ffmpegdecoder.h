@@ -0,0 +1,60 @@
+#ifndef FFMPEGDECODER_H
+#define FFMPEGDECODER_H
+
+#include <cstdint>
+
+#include "framedecoder.h"
+
+struct AVCodecContext;
+struct AVFormatContext;
+struct AVFrame;
+struct AVPacket;
+
+// Native libavformat / libavcodec decoder (VDT_WITH_FFMPEG builds only).
+// Unlike VideoCapture it decodes with frame + slice threading, seeks to the
+// exact PTS and hands out the YUV pictures themselves; swscale converts them
+// at display size for the screen, and to full-res BGR only when saving.
+class FfmpegDecoder : public FrameDecoder
+{
+public:
+    FfmpegDecoder() = default;
+    ~FfmpegDecoder() override;
+
+    FfmpegDecoder(const FfmpegDecoder &) = delete;
+    FfmpegDecoder &operator=(const FfmpegDecoder &) = delete;
+
+    bool open(const QString &path, const DecodeOptions &opt) override;
+    void close();
+    bool isOpen() const override { return codec_ != nullptr; }
+    QString backendName() const override { return QStringLiteral("libavcodec"); }
+    double nominalFps() const override { return fps_; }
+    int frameCountHint() const override { return frameCount_; }
+    cv::Size frameSize() const override;
+    QString codecName() const override;
+
+    bool grab(double &ptsMs) override;
+    bool retrieve(cv::Mat &bgr) override;
+    std::shared_ptr<const NativePicture> retrieveNative() override;
+    bool retrieveProxy(const cv::Size &maxSize, cv::Mat &bgr, cv::Size &fullSize) override;
+    double seekAndGrab(double targetMs) override;
+
+private:
+    bool decodeNext();                  // next frame into frame_, false at end
+    double ptsOf(const AVFrame *f) const;
+    bool seekBefore(double targetMs);
+    double decodeForwardTo(double targetMs);  // from the frame in frame_
+
+    AVFormatContext *fmt_ = nullptr;
+    AVCodecContext *codec_ = nullptr;
+    AVPacket *packet_ = nullptr;
+    AVFrame *frame_ = nullptr;
+    int stream_ = -1;
+    double timeBaseMs_ = 1.0;           // one stream tick in ms
+    int64_t startPts_ = 0;
+    double fps_ = 0.0;
+    int frameCount_ = 0;
+    bool draining_ = false;
+    bool hasFrame_ = false;
+};
+
+#endif // FFMPEGDECODER_H
@@ -0,0 +1,105 @@
+#include "fileutil.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+bool syncFile(QFileDevice &file)
+{
+    if (!file.isOpen() || !file.flush()) return false;
+    const int fd = file.handle();
+    if (fd < 0) return false;
+#ifdef Q_OS_WIN
+    return _commit(fd) == 0;
+#else
+    return ::fsync(fd) == 0;
+#endif
+}
+
+bool syncDirectory(const QString &dirPath)
+{
+#ifdef Q_OS_WIN
+    Q_UNUSED(dirPath);
+    return true;
+#else
+    const int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return false;
+    const bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#endif
+}
+
+bool replaceFile(const QString &from, const QString &to)
+{
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16()),
+                       reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16()),
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(QFile::encodeName(from).constData(), QFile::encodeName(to).constData()) == 0;
+#endif
+}
+
+bool moveFileNoReplace(const QString &from, const QString &to)
+{
+#ifdef Q_OS_WIN
+    return MoveFileExW(reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(from).utf16()),
+                       reinterpret_cast<LPCWSTR>(QDir::toNativeSeparators(to).utf16()),
+                       MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    const QByteArray src = QFile::encodeName(from);
+    const QByteArray dst = QFile::encodeName(to);
+    if (::link(src.constData(), dst.constData()) == 0) return ::unlink(src.constData()) == 0;
+    if (errno == EEXIST) return false;
+    // No hard links on this file system (FAT, some SMB mounts): best effort
+    return !QFileInfo::exists(to) && std::rename(src.constData(), dst.constData()) == 0;
+#endif
+}
+
+bool processAlive(qint64 pid)
+{
+    if (pid <= 0) return false;
+#ifdef Q_OS_WIN
+    HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(pid));
+    if (!h) return GetLastError() == ERROR_ACCESS_DENIED;
+    DWORD code = 0;
+    const bool alive = GetExitCodeProcess(h, &code) && code == STILL_ACTIVE;
+    CloseHandle(h);
+    return alive;
+#else
+    return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+}
+
+bool writeFileBytes(const QString &path, const char *data, qint64 size)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    const bool ok = f.write(data, size) == size;
+    f.close();
+    return ok && f.error() == QFileDevice::NoError;
+}
+
+QString sourceCacheKey(const QString &path)
+{
+    const QFileInfo fi(path);
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    h.addData(fi.absoluteFilePath().toUtf8());
+    h.addData(QByteArray::number(fi.size()));
+    h.addData(QByteArray::number(fi.lastModified().toMSecsSinceEpoch()));
+    return QString::fromLatin1(h.result().toHex());
+}
@@ -0,0 +1,32 @@
+#ifndef FILEUTIL_H
+#define FILEUTIL_H
+
+#include <QFileDevice>
+
+// Push written data of an open file down to the disk (fsync / _commit).
+bool syncFile(QFileDevice &file);
+
+// Make entries created / renamed in dirPath durable (fsync of the directory;
+// Windows has no equivalent and needs none after replaceFile()).
+bool syncDirectory(const QString &dirPath);
+
+// Atomically rename from over to, replacing an existing file (rename(2),
+// MoveFileEx on Windows): readers see the old or the new file, never none.
+bool replaceFile(const QString &from, const QString &to);
+
+// Atomically rename from to to unless to already exists (link + unlink,
+// MoveFileEx without replacing on Windows); false if it does.
+bool moveFileNoReplace(const QString &from, const QString &to);
+
+// Whether process pid of this machine is still running (kill(pid, 0) /
+// OpenProcess): owners of lock files and journals that are gone.
+bool processAlive(qint64 pid);
+
+// Create/overwrite path with exactly these bytes.
+bool writeFileBytes(const QString &path, const char *data, qint64 size);
+
+// Hex key for per-file caches (proxies, PTS tables): changes whenever the
+// file is replaced or modified.
+QString sourceCacheKey(const QString &path);
+
+#endif // FILEUTIL_H
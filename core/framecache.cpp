@@ -0,0 +1,96 @@
+#include "framecache.h"
+
+namespace {
+
+size_t frameBytes(const DecodedFrame &f)
+{
+    return f.bgr.total() * f.bgr.elemSize() + (f.native ? f.native->byteSize() : 0);
+}
+
+} // namespace
+
+FrameCache::FrameCache(size_t budgetBytes)
+    : budget_(budgetBytes)
+{
+}
+
+void FrameCache::setBudget(size_t bytes)
+{
+    budget_ = bytes;
+    evict();
+}
+
+void FrameCache::clear()
+{
+    lru_.clear();
+    byIndex_.clear();
+    bytes_ = 0;
+}
+
+void FrameCache::put(const DecodedFrame &f)
+{
+    if (f.isEmpty()) return;
+
+    auto it = byIndex_.find(f.index);
+    if (it != byIndex_.end())
+    {
+        bytes_ -= frameBytes(*it->second);
+        lru_.erase(it->second);
+        byIndex_.erase(it);
+    }
+
+    lru_.push_front(f);
+    byIndex_[f.index] = lru_.begin();
+    bytes_ += frameBytes(f);
+    evict();
+}
+
+bool FrameCache::get(int index, DecodedFrame &out)
+{
+    auto it = byIndex_.find(index);
+    if (it == byIndex_.end()) return false;
+    lru_.splice(lru_.begin(), lru_, it->second);
+    out = *it->second;
+    return true;
+}
+
+bool FrameCache::fetch(VideoSource &src, int index, DecodedFrame &out, int *skipped)
+{
+    if (skipped) *skipped = 0;
+    if (get(index, out)) return true;
+
+    bool ok = true;
+    const int gap = index - src.nextIndex();
+    if (gap >= 0 && gap <= kMaxSkipAhead)
+    {
+        while (ok && src.nextIndex() < index)
+        {
+            ok = src.skipNext();
+            if (ok && skipped) ++*skipped;
+        }
+        ok = ok && src.readNext(out);
+    }
+    else if (index < src.frameCount())
+    {
+        ok = src.seekToIndex(index, out);
+    }
+    else
+    {
+        ok = false;     // past the end; seekToIndex() would clamp
+    }
+
+    if (ok) put(out);
+    return ok;
+}
+
+void FrameCache::evict()
+{
+    // Always keep the most recent frame, even if it alone exceeds the budget
+    while (bytes_ > budget_ && lru_.size() > 1)
+    {
+        const DecodedFrame &old = lru_.back();
+        bytes_ -= frameBytes(old);
+        byIndex_.erase(old.index);
+        lru_.pop_back();
+    }
+}
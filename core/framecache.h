@@ -0,0 +1,39 @@
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <list>
+#include <unordered_map>
+
+#include "videosource.h"
+
+// Recently decoded frames by index (LRU, bounded by bytes), so stepping back
+// and forth around the current position does not re-seek the decoder.
+class FrameCache
+{
+public:
+    explicit FrameCache(size_t budgetBytes = 256u * 1024u * 1024u);
+
+    void setBudget(size_t bytes);
+    void clear();
+
+    void put(const DecodedFrame &f);
+    bool get(int index, DecodedFrame &out);     // refreshes recency
+    size_t bytes() const { return bytes_; }
+
+    // Cached frame, or decode it: short forward gaps are grabbed through,
+    // anything else is a seek. The result is cached.
+    bool fetch(VideoSource &src, int index, DecodedFrame &out, int *skipped = nullptr);
+
+private:
+    static constexpr int kMaxSkipAhead = 12;    // beyond this a seek is cheaper
+
+    using Lru = std::list<DecodedFrame>;
+    void evict();
+
+    Lru lru_;                                   // front = most recent
+    std::unordered_map<int, Lru::iterator> byIndex_;
+    size_t budget_;
+    size_t bytes_ = 0;
+};
+
+#endif // FRAMECACHE_H
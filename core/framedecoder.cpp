@@ -0,0 +1,48 @@
+#include "framedecoder.h"
+#include "opencvdecoder.h"
+#include "trace.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+#if defined(VDT_WITH_FFMPEG) && VDT_WITH_FFMPEG
+#include "ffmpegdecoder.h"
+#endif
+
+bool FrameDecoder::retrieveProxy(const cv::Size &maxSize, cv::Mat &bgr, cv::Size &fullSize)
+{
+    cv::Mat full;
+    if (!retrieve(full)) return false;
+    fullSize = full.size();
+
+    const cv::Size size = proxySizeFor(fullSize, maxSize);
+    if (size == fullSize)
+    {
+        bgr = full;
+        return true;
+    }
+    VDT_TRACE_SCOPE("proxy resize");
+    cv::resize(full, bgr, size, 0, 0, cv::INTER_AREA);
+    return true;
+}
+
+cv::Size proxySizeFor(const cv::Size &full, const cv::Size &maxSize)
+{
+    if (full.empty() || maxSize.empty()) return full;
+    const double scale = std::min({1.0,
+                                   static_cast<double>(maxSize.width) / full.width,
+                                   static_cast<double>(maxSize.height) / full.height});
+    return cv::Size(std::max(1, static_cast<int>(full.width * scale + 0.5)),
+                    std::max(1, static_cast<int>(full.height * scale + 0.5)));
+}
+
+std::unique_ptr<FrameDecoder> createDecoder(const DecodeOptions &opt)
+{
+#if defined(VDT_WITH_FFMPEG) && VDT_WITH_FFMPEG
+    if (opt.api == kApiLibav) return std::make_unique<FfmpegDecoder>();
+#else
+    Q_UNUSED(opt);
+#endif
+    return std::make_unique<OpenCvDecoder>();
+}
@@ -0,0 +1,65 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QString>
+
+#include <opencv2/core.hpp>
+
+#include <memory>
+
+#include "decodebackend.h"
+
+class QImage;
+class QSize;
+
+// Decoder-native picture (e.g. a YUV420 AVFrame) kept as is until pixels are
+// needed. Immutable, so it can be shared across threads.
+class NativePicture
+{
+public:
+    virtual ~NativePicture() = default;
+
+    virtual cv::Size size() const = 0;
+    virtual size_t byteSize() const = 0;
+    virtual bool toBgr(cv::Mat &bgr) const = 0;                         // full resolution
+    // Scale + convert in one pass; rgb32's buffer is reused when it fits.
+    virtual bool toDisplay(const QSize &size, QImage &rgb32) const = 0;
+};
+
+// Sequential decoder with exact seeking; what VideoSource drives.
+// grab() advances without converting pixels, retrieve() converts the last
+// grabbed frame. Timestamps are ms from the start of the stream.
+class FrameDecoder
+{
+public:
+    virtual ~FrameDecoder() = default;
+
+    virtual bool open(const QString &path, const DecodeOptions &opt) = 0;
+    virtual bool isOpen() const = 0;
+    virtual QString backendName() const = 0;
+    virtual double nominalFps() const = 0;          // 0 if unknown
+    virtual int frameCountHint() const = 0;         // container estimate
+    virtual cv::Size frameSize() const = 0;
+    virtual QString codecName() const { return QString(); }    // e.g. "h264", empty if unknown
+
+    virtual bool grab(double &ptsMs) = 0;
+    virtual bool retrieve(cv::Mat &bgr) = 0;        // writes into bgr's buffer when it fits
+    // Last grabbed frame without any conversion; nullptr if the decoder only
+    // hands out BGR.
+    virtual std::shared_ptr<const NativePicture> retrieveNative() { return nullptr; }
+    // Last grabbed frame as BGR scaled to fit maxSize (never enlarged).
+    // The default converts at full size and resizes; decoders that can scale
+    // in their conversion step override it.
+    virtual bool retrieveProxy(const cv::Size &maxSize, cv::Mat &bgr, cv::Size &fullSize);
+    // Positions on the frame shown at targetMs and grabs it. Returns its PTS,
+    // or a negative value at end of stream.
+    virtual double seekAndGrab(double targetMs) = 0;
+};
+
+// Largest size with full's aspect ratio inside maxSize, at most full itself.
+cv::Size proxySizeFor(const cv::Size &full, const cv::Size &maxSize);
+
+// cv::VideoCapture, or the native libavcodec decoder for kApiLibav.
+std::unique_ptr<FrameDecoder> createDecoder(const DecodeOptions &opt);
+
+#endif // FRAMEDECODER_H
@@ -0,0 +1,94 @@
+#include "frameoutput.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+cv::Size outputSizeFor(const OutputSettings &s, cv::Size cropSize)
+{
+    int w = s.size.width;
+    int h = s.size.height;
+    if (w <= 0 && h <= 0) return cropSize;
+    if (cropSize.width <= 0 || cropSize.height <= 0) return cropSize;
+
+    const double aspect = static_cast<double>(cropSize.width) / cropSize.height;
+    if (w <= 0) w = static_cast<int>(std::lround(h * aspect));
+    if (h <= 0) h = static_cast<int>(std::lround(w / aspect));
+    return cv::Size(std::max(1, w), std::max(1, h));
+}
+
+cv::Mat prepareOutputFrame(const cv::Mat &bgr, const OutputSettings &s)
+{
+    if (bgr.empty() || s.isIdentity()) return bgr;
+
+    // Crop is just a header into the decoded frame, no copy
+    cv::Rect roi = s.roi.empty() ? cv::Rect(0, 0, bgr.cols, bgr.rows)
+                                 : (s.roi & cv::Rect(0, 0, bgr.cols, bgr.rows));
+    if (roi.empty()) roi = cv::Rect(0, 0, bgr.cols, bgr.rows);
+    const cv::Mat crop = bgr(roi);
+
+    const cv::Size outSize = outputSizeFor(s, roi.size());
+    const bool resize = outSize != roi.size();
+    const bool shrinking = outSize.area() < roi.area();
+    const bool gray = s.grayscale && crop.channels() != 1;
+
+    cv::Mat out;
+    if (!resize)
+    {
+        if (gray) cv::cvtColor(crop, out, crop.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+        else      out = crop.clone();   // detach from the cached frame
+        return out;
+    }
+
+    // Convert on whichever side of the resize has fewer pixels
+    const int interp = shrinking ? cv::INTER_AREA : cv::INTER_LINEAR;
+    if (gray && !shrinking)
+    {
+        cv::Mat g;
+        cv::cvtColor(crop, g, crop.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+        cv::resize(g, out, outSize, 0, 0, interp);
+    }
+    else
+    {
+        cv::resize(crop, out, outSize, 0, 0, interp);
+        if (gray) cv::cvtColor(out, out, out.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    }
+    return out;
+}
+
+std::vector<OutputLevel> buildOutputLevels(const cv::Mat &bgr, const OutputSettings &s)
+{
+    std::vector<OutputLevel> levels;
+    if (bgr.empty()) return levels;
+
+    levels.emplace_back();
+    levels.back().image = prepareOutputFrame(bgr, s);
+
+    std::vector<int> widths = s.pyramidWidths;
+    std::sort(widths.begin(), widths.end(), std::greater<int>());
+    widths.erase(std::unique(widths.begin(), widths.end()), widths.end());
+
+    for (int w : widths)
+    {
+        const cv::Mat &prev = levels.back().image;
+        if (w <= 0 || w >= prev.cols) continue;
+        const int h = std::max(1, static_cast<int>(std::lround(static_cast<double>(prev.rows) * w / prev.cols)));
+
+        OutputLevel level;
+        // Exact halving is what pyrDown is for; anything else goes through INTER_AREA
+        if (std::abs(prev.cols - 2 * w) <= 1 && std::abs(prev.rows - 2 * h) <= 1)
+            cv::pyrDown(prev, level.image, cv::Size(w, h));
+        else
+            cv::resize(prev, level.image, cv::Size(w, h), 0, 0, cv::INTER_AREA);
+        levels.push_back(std::move(level));
+    }
+    return levels;
+}
+
+void encodeLevels(std::vector<OutputLevel> &levels, const std::string &ext)
+{
+    cv::parallel_for_(cv::Range(0, static_cast<int>(levels.size())), [&](const cv::Range &r) {
+        for (int i = r.start; i < r.end; ++i)
+            levels[i].ok = cv::imencode(ext, levels[i].image, levels[i].encoded);
+    });
+}
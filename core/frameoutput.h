@@ -0,0 +1,41 @@
+#ifndef FRAMEOUTPUT_H
+#define FRAMEOUTPUT_H
+
+#include <opencv2/opencv.hpp>
+
+#include <string>
+#include <vector>
+
+// What a saved frame should look like, applied once right before encoding.
+struct OutputSettings
+{
+    cv::Rect roi;               // source pixels; empty = whole frame
+    cv::Size size;              // target size; 0 in a dimension = derive from aspect
+    bool grayscale = false;
+    std::vector<int> pyramidWidths;   // extra smaller copies, saved into "<w>px/"
+
+    bool isIdentity() const { return roi.empty() && size.width <= 0 && size.height <= 0 && !grayscale; }
+};
+
+// Output size for a crop of cropSize under these settings.
+cv::Size outputSizeFor(const OutputSettings &s, cv::Size cropSize);
+
+// Crop + resize + (optional) colour convert in one step: the crop is a view,
+// resize reads only the ROI, and grey conversion runs at the smaller size.
+cv::Mat prepareOutputFrame(const cv::Mat &bgr, const OutputSettings &s);
+
+struct OutputLevel
+{
+    cv::Mat image;
+    std::vector<uchar> encoded;
+    bool ok = false;
+};
+
+// The prepared frame followed by one level per extra width (largest first).
+// Each level is downsampled from the previous one, never from the source.
+std::vector<OutputLevel> buildOutputLevels(const cv::Mat &bgr, const OutputSettings &s);
+
+// Encodes all levels concurrently (ext like ".png").
+void encodeLevels(std::vector<OutputLevel> &levels, const std::string &ext);
+
+#endif // FRAMEOUTPUT_H
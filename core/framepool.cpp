@@ -0,0 +1,128 @@
+#include "framepool.h"
+
+FramePool &FramePool::instance()
+{
+    static FramePool pool;
+    return pool;
+}
+
+FramePool::FramePool(size_t maxFree, size_t maxFreeBytes)
+    : maxFree_(maxFree), maxFreeBytes_(maxFreeBytes)
+{
+}
+
+FramePool::~FramePool()
+{
+    trim();
+}
+
+void FramePool::setMaxFree(size_t n)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxFree_ = n;
+    shrinkLocked();
+}
+
+void FramePool::shrinkLocked() const
+{
+    while (!free_.empty() && (free_.size() > maxFree_ || freeBytes_ > maxFreeBytes_))
+    {
+        freeBytes_ -= free_.front().size;
+        cv::fastFree(free_.front().data);
+        free_.erase(free_.begin());
+    }
+}
+
+void FramePool::trim()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const Block &b : free_) cv::fastFree(b.data);
+    free_.clear();
+    freeBytes_ = 0;
+}
+
+FramePool::Stats FramePool::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats s;
+    s.freeBuffers = free_.size();
+    s.freeBytes = freeBytes_;
+    s.reused = reused_;
+    s.allocated = allocated_;
+    return s;
+}
+
+uchar *FramePool::take(size_t bytes) const
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Frame sizes are fixed per video, so exact matches are the normal case.
+        // Newest first: its pages are the most likely to still be resident.
+        for (auto it = free_.rbegin(); it != free_.rend(); ++it)
+        {
+            if (it->size == bytes)
+            {
+                uchar *data = it->data;
+                freeBytes_ -= bytes;
+                free_.erase(std::next(it).base());
+                ++reused_;
+                return data;
+            }
+        }
+        ++allocated_;
+    }
+    return static_cast<uchar *>(cv::fastMalloc(bytes));
+}
+
+void FramePool::give(uchar *data, size_t bytes) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_.push_back({data, bytes});
+    freeBytes_ += bytes;
+    shrinkLocked();
+}
+
+// Same bookkeeping as OpenCV's default allocator, with take() / give()
+// in place of fastMalloc() / fastFree().
+cv::UMatData *FramePool::allocate(int dims, const int *sizes, int type, void *data0,
+                                  size_t *step, cv::AccessFlag, cv::UMatUsageFlags) const
+{
+    size_t total = CV_ELEM_SIZE(type);
+    for (int i = dims - 1; i >= 0; --i)
+    {
+        if (step)
+        {
+            if (data0 && step[i] != CV_AUTOSTEP)
+            {
+                CV_Assert(total <= step[i]);
+                total = step[i];
+            }
+            else
+            {
+                step[i] = total;
+            }
+        }
+        total *= sizes[i];
+    }
+
+    auto *u = new cv::UMatData(this);
+    u->data = u->origdata = data0 ? static_cast<uchar *>(data0) : take(total);
+    u->size = total;
+    if (data0) u->flags |= cv::UMatData::USER_ALLOCATED;
+    return u;
+}
+
+bool FramePool::allocate(cv::UMatData *, cv::AccessFlag, cv::UMatUsageFlags) const
+{
+    return false;   // host memory only
+}
+
+void FramePool::deallocate(cv::UMatData *u) const
+{
+    if (!u) return;
+    CV_Assert(u->urefcount == 0);
+    CV_Assert(u->refcount == 0);
+    if (!(u->flags & cv::UMatData::USER_ALLOCATED))
+        give(u->origdata, u->size);
+    delete u;
+}
@@ -0,0 +1,61 @@
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <opencv2/core.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Recycles full-frame pixel buffers through decode -> cache -> display -> save.
+// Plugs into cv::Mat as its allocator: set mat.allocator before create() and
+// the buffer comes back here when the last Mat referencing it goes away, from
+// whichever thread that happens on. Buffers are 64-byte aligned.
+class FramePool : public cv::MatAllocator
+{
+public:
+    struct Stats
+    {
+        size_t freeBuffers = 0;
+        size_t freeBytes = 0;
+        uint64_t reused = 0;
+        uint64_t allocated = 0;
+    };
+
+    static FramePool &instance();
+
+    // Idle buffers are capped by count and by bytes, whichever is hit first:
+    // 16 small frames, but only a handful of 4K ones.
+    explicit FramePool(size_t maxFree = 16, size_t maxFreeBytes = 128u * 1024u * 1024u);
+    ~FramePool() override;
+
+    void setMaxFree(size_t n);
+    void trim();                            // release every idle buffer
+    Stats stats() const;
+
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data,
+                           size_t *step, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override;
+    bool allocate(cv::UMatData *data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usage) const override;
+    void deallocate(cv::UMatData *data) const override;
+
+private:
+    struct Block
+    {
+        uchar *data;
+        size_t size;
+    };
+
+    uchar *take(size_t bytes) const;
+    void give(uchar *data, size_t bytes) const;
+    void shrinkLocked() const;              // oldest idle buffers go first
+
+    mutable std::mutex mutex_;
+    mutable std::vector<Block> free_;       // most recently returned last
+    mutable size_t freeBytes_ = 0;
+    size_t maxFree_;
+    size_t maxFreeBytes_;
+    mutable uint64_t reused_ = 0;
+    mutable uint64_t allocated_ = 0;
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,182 @@
+#include "framesink.h"
+#include "datasetindex.h"
+#include "perfstats.h"
+#include "trace.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+
+#include <algorithm>
+
+namespace {
+
+QByteArray sha256Hex(const std::vector<uchar> &bytes)
+{
+    return QCryptographicHash::hash(QByteArray::fromRawData(reinterpret_cast<const char*>(bytes.data()),
+                                                            static_cast<qsizetype>(bytes.size())),
+                                    QCryptographicHash::Sha256).toHex();
+}
+
+} // namespace
+
+FrameSink::FrameSink()
+    : inFlight_(std::max(2, 2 * QThreadPool::globalInstance()->maxThreadCount()))
+{
+}
+
+FrameSink::~FrameSink()
+{
+    pool_.waitForDone();
+}
+
+bool FrameSink::save(const SaveJob &job, QString *fileName)
+{
+    QElapsedTimer t;
+    t.start();
+    QString name = job.fileName;
+    const bool ok = run(job, name);
+    if (fileName) *fileName = name;
+    if (stats_) stats_->add(PerfStats::Save, t.nsecsElapsed() / 1e6);
+    return ok;
+}
+
+void FrameSink::submit(SaveJob job, Done done)
+{
+    inFlight_.acquire();
+    pool_.start([this, job = std::move(job), done = std::move(done)]() {
+        VDT_TRACE_THREAD("encoder");
+        QString name;
+        const bool ok = save(job, &name);
+        inFlight_.release();
+        if (done) done(ok, name);
+    });
+}
+
+void FrameSink::waitForDone()
+{
+    pool_.waitForDone();
+}
+
+bool FrameSink::run(const SaveJob &job, QString &fileName)
+{
+    // Crop / resize / convert once, derive the extra resolutions from it,
+    // then encode every level in parallel (encode ourselves so the manifest
+    // can hash the exact bytes)
+    VDT_TRACE_SCOPE("save");
+    std::vector<OutputLevel> levels;
+    {
+        VDT_TRACE_SCOPE("crop/resize");
+        levels = buildOutputLevels(job.frame, job.output);
+    }
+    if (levels.empty()) return false;
+    {
+        VDT_TRACE_SCOPE("imencode");
+        encodeLevels(levels, ".png");
+    }
+
+    QDir dir(job.saveDir);
+    QByteArray sha256;
+    if (job.contentNamed && !levels[0].encoded.empty())
+    {
+        VDT_TRACE_SCOPE("hash");
+        sha256 = sha256Hex(levels[0].encoded);
+        fileName = DatasetIndex::contentFileNameFor(sha256);
+    }
+    if (fileName.isEmpty()) return false;
+
+    // Content names are never journaled: another save (another encoder thread,
+    // another process) may write or have written the same bytes under the same
+    // name, so existing files count as written and abort / recovery must not
+    // touch them
+    const bool journaled = !job.contentNamed;
+    if (journaled && !journal_.begin(job.saveDir, fileName)) return false;
+
+    const QDateTime savedAt = QDateTime::currentDateTimeUtc();
+    std::vector<FrameRecord> records;
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        const OutputLevel &level = levels[i];
+
+        // Level 0 goes to the save dir, smaller ones to "<w>px/"
+        QString relPath = fileName;
+        if (i > 0)
+            relPath = QString("%1px/%2").arg(level.image.cols).arg(fileName);
+        const QString path = dir.filePath(relPath);
+
+        VDT_TRACE_SCOPE("imwrite");
+        const bool ok = level.ok && QDir().mkpath(QFileInfo(path).absolutePath())
+                        && SaveJournal::writeAndSync(path,
+                                                     reinterpret_cast<const char*>(level.encoded.data()),
+                                                     static_cast<qint64>(level.encoded.size()),
+                                                     job.contentNamed);
+        if (!ok)
+        {
+            if (journaled) journal_.abort(job.saveDir, fileName);
+            return false;
+        }
+
+        FrameRecord rec;
+        rec.manifestPath = dir.filePath("manifest.jsonl");
+        rec.imageName = relPath;
+        rec.sourcePath = job.sourcePath;
+        rec.frameIndex = job.frameIndex;
+        rec.ptsMs = job.ptsMs;
+        rec.width = level.image.cols;
+        rec.height = level.image.rows;
+        if (!job.output.roi.empty())
+            rec.crop = QRect(job.output.roi.x, job.output.roi.y, job.output.roi.width, job.output.roi.height);
+        rec.savedAt = savedAt;
+        // Hashed here rather than queued: the manifest queue would otherwise
+        // hold a copy of every encoded level until its thread caught up
+        {
+            VDT_TRACE_SCOPE("hash");
+            rec.sha256 = (i == 0 && !sha256.isEmpty()) ? sha256 : sha256Hex(level.encoded);
+        }
+        records.push_back(std::move(rec));
+    }
+
+    if (!writeAnnotations(job, fileName, levels[0].image.size()))
+    {
+        if (journaled) journal_.abort(job.saveDir, fileName);
+        return false;
+    }
+
+    // Provenance only for images that are known to be complete; for content
+    // names every save of the same bytes adds its source to the hash
+    if (journaled && !journal_.commit(job.saveDir, fileName)) return false;
+    for (FrameRecord &rec : records)
+        manifest_.append(std::move(rec));
+    return true;
+}
+
+bool FrameSink::writeAnnotations(const SaveJob &job, const QString &fileName, cv::Size imageSize)
+{
+    if (job.annotations.empty() || job.annotationFormats == 0) return true;
+    VDT_TRACE_SCOPE("annotations");
+
+    const std::vector<Annotation> mapped = mapAnnotationsToOutput(job.annotations, job.output, job.frame.size());
+    QDir dir(job.saveDir);
+    const QString base = dir.filePath(fileName.left(fileName.lastIndexOf('.')));
+    bool ok = true;
+    QStringList classes = job.classes;
+    if (job.annotationFormats & AnnotationYolo)
+    {
+        // Ids index classes.txt, which other jobs / annotators share: merged,
+        // it only ever grows, so older label files stay valid
+        {
+            std::lock_guard<std::mutex> lock(classesMutex_);
+            if (!DatasetIndex::mergeClasses(job.saveDir, classes)) return false;
+        }
+        const QByteArray yolo = annotationsToYolo(mapped, imageSize, classes);
+        ok = ok && SaveJournal::writeAndSync(base + ".txt", yolo.constData(), yolo.size());
+    }
+    if (job.annotationFormats & AnnotationCoco)
+    {
+        const QByteArray coco = annotationsToCoco(mapped, imageSize, fileName, classes);
+        ok = ok && SaveJournal::writeAndSync(base + ".json", coco.constData(), coco.size());
+    }
+    return ok;
+}
@@ -0,0 +1,76 @@
+#ifndef FRAMESINK_H
+#define FRAMESINK_H
+
+#include <QSemaphore>
+#include <QString>
+#include <QThreadPool>
+
+#include <opencv2/opencv.hpp>
+
+#include <functional>
+#include <mutex>
+
+#include "annotations.h"
+#include "frameoutput.h"
+#include "manifestwriter.h"
+#include "savejournal.h"
+
+class PerfStats;
+
+// Everything needed to turn one decoded frame into files on disk.
+// Self-contained so it can run on any thread.
+struct SaveJob
+{
+    cv::Mat frame;              // full-resolution BGR, never written to afterwards
+    OutputSettings output;
+    QString saveDir;
+    QString fileName;           // e.g. image_0042.png; set by the sink if contentNamed
+    bool contentNamed = false;  // named by hash of the encoded image (ab/cd/<sha256>.png)
+    QString sourcePath;
+    int frameIndex = 0;
+    double ptsMs = 0.0;
+
+    // Written next to level 0 (see AnnotationFormat) when not empty
+    std::vector<Annotation> annotations;        // source frame pixels
+    QStringList classes;                        // merged into classes.txt, whose order gives the ids
+    int annotationFormats = 0;
+};
+
+// Writes frames: prepare, encode all levels, write files, log provenance.
+// save() runs on the caller's thread; submit() goes to the encoder pool.
+// Numbered saves are journaled (SaveJournal), so a crash never leaves a half
+// written image behind once the directory is recovered; content-named files
+// are only ever created whole.
+class FrameSink
+{
+public:
+    using Done = std::function<void(bool ok, const QString &fileName)>;
+
+    FrameSink();
+    ~FrameSink();               // waits for submitted jobs
+
+    FrameSink(const FrameSink &) = delete;
+    FrameSink &operator=(const FrameSink &) = delete;
+
+    void setStats(PerfStats *stats) { stats_ = stats; }
+
+    // fileName receives the name written (job.fileName unless contentNamed).
+    bool save(const SaveJob &job, QString *fileName = nullptr);
+    // Blocks while too many frames are in flight, so producers cannot run
+    // away from the encoders. done runs on a pool thread.
+    void submit(SaveJob job, Done done);
+    void waitForDone();
+
+private:
+    bool run(const SaveJob &job, QString &fileName);
+    bool writeAnnotations(const SaveJob &job, const QString &fileName, cv::Size imageSize);
+
+    ManifestWriter manifest_;
+    SaveJournal journal_;
+    std::mutex classesMutex_;   // classes.txt is shared by all encoder threads
+    QThreadPool pool_;
+    QSemaphore inFlight_;
+    PerfStats *stats_ = nullptr;
+};
+
+#endif // FRAMESINK_H
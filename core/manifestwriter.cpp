@@ -0,0 +1,135 @@
+#include "manifestwriter.h"
+#include "fileutil.h"
+#include "trace.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <chrono>
+
+ManifestWriter::ManifestWriter()
+{
+    thread_ = std::thread(&ManifestWriter::run, this);
+}
+
+ManifestWriter::~ManifestWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_one();
+    thread_.join();
+}
+
+void ManifestWriter::append(FrameRecord rec)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push_back(std::move(rec));
+    }
+    wake_.notify_one();
+}
+
+void ManifestWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushRequested_ = true;
+    wake_.notify_one();
+    drained_.wait(lock, [this]() { return !flushRequested_; });
+}
+
+static QByteArray recordToJsonLine(const FrameRecord &rec)
+{
+    QJsonObject o;
+    o["image"]    = rec.imageName;
+    o["source"]   = rec.sourcePath;
+    o["sha256"]   = QString::fromLatin1(rec.sha256);
+    o["frame"]    = rec.frameIndex;
+    o["pts_ms"]   = rec.ptsMs;
+    o["width"]    = rec.width;
+    o["height"]   = rec.height;
+    o["saved_at"] = rec.savedAt.toUTC().toString(Qt::ISODateWithMs);
+    if (!rec.crop.isNull())
+        o["crop"] = QJsonArray{rec.crop.x(), rec.crop.y(), rec.crop.width(), rec.crop.height()};
+    return QJsonDocument(o).toJson(QJsonDocument::Compact) + '\n';
+}
+
+void ManifestWriter::run()
+{
+    VDT_TRACE_THREAD("manifest");
+    QFile file;
+    int unsynced = 0;
+    QElapsedTimer sinceFirstUnsynced;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;)
+    {
+        if (queue_.empty())
+        {
+            const bool syncDue = unsynced > 0
+                && (flushRequested_ || stop_ || sinceFirstUnsynced.elapsed() >= kSyncIntervalMs);
+            if (syncDue)
+            {
+                lock.unlock();
+                syncFile(file);
+                lock.lock();
+                unsynced = 0;
+                continue;   // more may have arrived meanwhile
+            }
+            if (flushRequested_)
+            {
+                flushRequested_ = false;
+                drained_.notify_all();
+            }
+            if (stop_) break;
+
+            if (unsynced > 0)
+                wake_.wait_for(lock, std::chrono::milliseconds(kSyncIntervalMs - sinceFirstUnsynced.elapsed()));
+            else
+                wake_.wait(lock);
+            continue;
+        }
+
+        FrameRecord rec = std::move(queue_.front());
+        queue_.pop_front();
+        lock.unlock();
+
+        // Save dir changed => switch manifests
+        if (file.fileName() != rec.manifestPath)
+        {
+            if (file.isOpen())
+            {
+                syncFile(file);
+                file.close();
+            }
+            unsynced = 0;
+            file.setFileName(rec.manifestPath);
+            file.open(QIODevice::WriteOnly | QIODevice::Append);
+        }
+
+        if (file.isOpen())
+        {
+            VDT_TRACE_SCOPE("manifest append");
+            file.write(recordToJsonLine(rec));
+            if (unsynced++ == 0) sinceFirstUnsynced.start();
+            if (unsynced >= kSyncEvery)
+            {
+                syncFile(file);
+                unsynced = 0;
+            }
+        }
+
+        lock.lock();
+    }
+    lock.unlock();
+
+    if (file.isOpen())
+    {
+        syncFile(file);
+        file.close();
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef MANIFESTWRITER_H
+#define MANIFESTWRITER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QRect>
+#include <QString>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+// Where a saved image came from. One JSON line per save in manifest.jsonl.
+struct FrameRecord
+{
+    QString manifestPath;   // manifest the record goes to (one per save dir)
+    QString imageName;      // relative to the save dir
+    QString sourcePath;     // video the frame was taken from
+    QByteArray sha256;      // hex, of the file bytes as written
+    int frameIndex = 0;
+    double ptsMs = 0.0;
+    int width = 0;
+    int height = 0;
+    QRect crop;             // source region saved; null = whole frame
+    QDateTime savedAt;
+};
+
+// Append-only provenance log written off the GUI thread.
+// Records are fsync'ed in batches (every kSyncEvery records or kSyncIntervalMs).
+class ManifestWriter
+{
+public:
+    ManifestWriter();
+    ~ManifestWriter();      // drains the queue and syncs
+
+    ManifestWriter(const ManifestWriter &) = delete;
+    ManifestWriter &operator=(const ManifestWriter &) = delete;
+
+    void append(FrameRecord rec);
+    void flush();           // blocks until everything queued is on disk
+
+private:
+    static constexpr int kSyncEvery = 32;
+    static constexpr int kSyncIntervalMs = 1000;
+
+    void run();
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    std::deque<FrameRecord> queue_;
+    bool flushRequested_ = false;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+#endif // MANIFESTWRITER_H
@@ -0,0 +1,117 @@
+#include "objecttracker.h"
+#include "trace.h"
+#include "videosource.h"
+
+#if __has_include(<opencv2/tracking.hpp>)
+#include <opencv2/tracking.hpp>
+#define VDT_HAVE_CSRT 1
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+cv::Ptr<cv::Tracker> createTracker()
+{
+#ifdef VDT_HAVE_CSRT
+    return cv::TrackerCSRT::create();
+#else
+    return cv::TrackerMIL::create();
+#endif
+}
+
+// Scale between the tracked (proxy) frame and source pixels
+double scaleOf(const DecodedFrame &f)
+{
+    const cv::Size full = f.size();
+    return full.width > 0 ? static_cast<double>(f.bgr.cols) / full.width : 1.0;
+}
+
+cv::Rect toTracked(const cv::Rect2d &box, double s)
+{
+    return cv::Rect(cv::Point(cvRound(box.x * s), cvRound(box.y * s)),
+                    cv::Point(cvRound(box.br().x * s), cvRound(box.br().y * s)));
+}
+
+cv::Rect2d toSource(const cv::Rect &box, double s)
+{
+    return cv::Rect2d(box.x / s, box.y / s, box.width / s, box.height / s);
+}
+
+} // namespace
+
+QString ObjectTracker::trackerName()
+{
+#ifdef VDT_HAVE_CSRT
+    return "CSRT";
+#else
+    return "MIL";
+#endif
+}
+
+int ObjectTracker::run(const TrackRequest &req, const std::atomic_bool *cancel,
+                       const std::function<bool(int, const cv::Rect2d &)> &sink)
+{
+    VDT_TRACE_SCOPE("track");
+    if (req.box.width <= 0.0 || req.box.height <= 0.0) return 0;
+    VideoSource src;
+    src.setOptions(req.decode);
+    if (!src.open(req.path)) return 0;
+    if (!req.timeline.isEmpty()) src.setTimeline(req.timeline);
+    // Decoder-side downscale: trackers gain little from 4K and cost a lot
+    src.setProxySize(cv::Size(kTrackWidth, kTrackWidth * 4));
+
+    cv::Ptr<cv::Tracker> tracker = createTracker();
+    std::atomic_bool stop(false);
+    bool initialised = false;
+    int tracked = 0;
+
+    // Feeds one frame; false once tracking is over
+    auto step = [&](const DecodedFrame &f) {
+        if (stop || (cancel && cancel->load()) || f.bgr.empty()) return false;
+        const double s = scaleOf(f);
+        if (!initialised)
+        {
+            // A seek may land before startFrame; landing after it (or a start
+            // box that vanishes at tracking size) leaves nothing to track from
+            if (req.direction >= 0 && f.index < req.startFrame) return true;
+            const cv::Rect start = toTracked(req.box, s) & cv::Rect(0, 0, f.bgr.cols, f.bgr.rows);
+            if (f.index != req.startFrame || start.empty()) return false;
+            tracker->init(f.bgr, start);
+            initialised = true;
+            return true;
+        }
+        cv::Rect box;
+        if (!tracker->update(f.bgr, box) || box.empty()) return false;
+        ++tracked;
+        return sink(f.index, toSource(box, s)) && tracked < req.maxFrames;
+    };
+
+    // The tracker (or the decoder) may throw on odd input: that ends the run
+    // with what was tracked so far, like losing the object
+    try
+    {
+        if (req.direction >= 0)
+        {
+            const int last = std::min(src.frameCount() - 1, req.startFrame + req.maxFrames);
+            src.decodeRange(req.startFrame, last, 1, &stop, [&](DecodedFrame &&f) {
+                if (!step(f)) stop = true;
+            });
+            return tracked;
+        }
+
+        // Backward: decode the window forward once, then walk it in reverse
+        const int first = std::max(0, req.startFrame - std::min(req.maxFrames, kMaxBackwardFrames));
+        std::vector<DecodedFrame> frames;
+        src.decodeRange(first, req.startFrame, 1, cancel, [&](DecodedFrame &&f) {
+            frames.push_back(std::move(f));
+        });
+        for (auto it = frames.rbegin(); it != frames.rend(); ++it)
+            if (!step(*it)) break;
+    }
+    catch (const cv::Exception &)
+    {
+    }
+    return tracked;
+}
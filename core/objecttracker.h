@@ -0,0 +1,44 @@
+#ifndef OBJECTTRACKER_H
+#define OBJECTTRACKER_H
+
+#include <QString>
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <functional>
+
+#include "decodebackend.h"
+#include "videotimeline.h"
+
+// Follows one box through a video with an OpenCV CPU tracker: CSRT when the
+// contrib tracking module is available, the built-in MIL tracker otherwise.
+// Runs on its own decoder (call it from a worker thread) at a reduced size.
+struct TrackRequest
+{
+    QString path;
+    DecodeOptions decode;
+    VideoTimeline timeline;     // the scanned table, so indices match the caller's
+    int startFrame = 0;
+    cv::Rect2d box;             // on startFrame, source frame pixels
+    int direction = 1;          // +1 forward, -1 backward
+    int maxFrames = 300;
+};
+
+class ObjectTracker
+{
+public:
+    static constexpr int kTrackWidth = 640;         // frames are tracked at most this wide
+    static constexpr int kMaxBackwardFrames = 150;  // held in memory to walk them in reverse
+
+    static QString trackerName();
+
+    // sink gets every frame after startFrame (in tracking order) until the
+    // tracker loses the object, sink returns false, maxFrames or cancel.
+    // Returns how many frames were tracked: 0 for an empty box or when decoding
+    // does not reach startFrame. Tracker errors end the run, never throw.
+    static int run(const TrackRequest &req, const std::atomic_bool *cancel,
+                   const std::function<bool(int frame, const cv::Rect2d &box)> &sink);
+};
+
+#endif // OBJECTTRACKER_H
@@ -0,0 +1,167 @@
+#include "onnxdetector.h"
+#include "trace.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <algorithm>
+
+namespace {
+
+// Scaled into the top-left corner of the square input, so mapping back is a
+// single division
+cv::Mat letterbox(const cv::Mat &img, double &scale)
+{
+    const int size = OnnxDetector::kInputSize;
+    scale = std::min(static_cast<double>(size) / img.cols, static_cast<double>(size) / img.rows);
+    const cv::Size scaled(std::clamp(cvRound(img.cols * scale), 1, size), std::clamp(cvRound(img.rows * scale), 1, size));
+    cv::Mat resized;
+    cv::resize(img, resized, scaled, 0, 0, cv::INTER_AREA);
+    cv::Mat out(size, size, CV_8UC3, cv::Scalar(114, 114, 114));
+    resized.copyTo(out(cv::Rect(cv::Point(), scaled)));
+    return out;
+}
+
+QStringList readClassNames(const QString &modelPath)
+{
+    const QFileInfo fi(modelPath);
+    for (const QString &name : {fi.completeBaseName() + ".names", QString("classes.txt")})
+    {
+        QFile f(fi.dir().filePath(name));
+        if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) continue;
+        QStringList names;
+        QTextStream in(&f);
+        while (!in.atEnd())
+        {
+            const QString line = in.readLine().trimmed();
+            if (!line.isEmpty()) names << line;
+        }
+        return names;
+    }
+    return QStringList();
+}
+
+} // namespace
+
+bool OnnxDetector::load(const QString &path, QString *error)
+{
+    net_ = cv::dnn::Net();
+    path_.clear();
+    classes_.clear();
+    batched_ = true;
+    try
+    {
+        net_ = cv::dnn::readNetFromONNX(path.toStdString());
+    }
+    catch (const cv::Exception &e)
+    {
+        if (error) *error = QString::fromStdString(e.msg);
+        return false;
+    }
+    if (net_.empty()) return false;
+
+    net_.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+    net_.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+    path_ = path;
+    classes_ = readClassNames(path);
+    return true;
+}
+
+QString OnnxDetector::className(int id) const
+{
+    return id >= 0 && id < classes_.size() ? classes_[id] : QString("class %1").arg(id);
+}
+
+std::vector<std::vector<Detection>> OnnxDetector::detect(const std::vector<cv::Mat> &images)
+{
+    VDT_TRACE_SCOPE("detect");
+    std::vector<std::vector<Detection>> results(images.size());
+    if (!isLoaded() || images.empty()) return results;
+
+    std::vector<cv::Mat> inputs(images.size());
+    std::vector<double> scales(images.size());
+    for (size_t i = 0; i < images.size(); ++i)
+        inputs[i] = letterbox(images[i], scales[i]);
+
+    // out is [batch, rows, cols]; per image a rows x cols float matrix
+    auto run = [this](const std::vector<cv::Mat> &batch) {
+        net_.setInput(cv::dnn::blobFromImages(batch, 1.0 / 255.0, cv::Size(kInputSize, kInputSize),
+                                              cv::Scalar(), true, false));
+        return net_.forward();
+    };
+    auto collect = [&](const cv::Mat &out, size_t first, size_t count) {
+        if (out.dims != 3 || static_cast<size_t>(out.size[0]) < count) return;
+        const int rows = out.size[1];
+        const int cols = out.size[2];
+        for (size_t i = 0; i < count; ++i)
+        {
+            const cv::Mat m(rows, cols, CV_32F, const_cast<float *>(out.ptr<float>(static_cast<int>(i))));
+            // Attributes along the short axis: YOLOv8 has far fewer than boxes
+            const bool transposed = rows < cols;
+            results[first + i] = parse(transposed ? cv::Mat(m.t()) : m, transposed, scales[first + i]);
+        }
+    };
+
+    try
+    {
+        if (batched_ && inputs.size() > 1)
+        {
+            try
+            {
+                collect(run(inputs), 0, inputs.size());
+                return results;
+            }
+            catch (const cv::Exception &)
+            {
+                batched_ = false;   // exported with a fixed batch of 1
+            }
+        }
+        for (size_t i = 0; i < inputs.size(); ++i)
+            collect(run({inputs[i]}), i, 1);
+    }
+    catch (const cv::Exception &)
+    {
+        // Model does not fit the expected layout; nothing suggested
+    }
+    return results;
+}
+
+std::vector<Detection> OnnxDetector::parse(const cv::Mat &rows, bool transposed, double scale) const
+{
+    // YOLOv8: cx, cy, w, h, class scores; YOLOv5 adds objectness before them
+    const int first = transposed ? 4 : 5;
+    std::vector<Detection> found;
+    if (rows.cols <= first) return found;
+
+    std::vector<cv::Rect> nmsBoxes;
+    std::vector<float> scores;
+    for (int r = 0; r < rows.rows; ++r)
+    {
+        const float *p = rows.ptr<float>(r);
+        const cv::Mat classScores(1, rows.cols - first, CV_32F, const_cast<float *>(p + first));
+        double best = 0.0;
+        cv::Point cls;
+        cv::minMaxLoc(classScores, nullptr, &best, nullptr, &cls);
+        const float score = transposed ? static_cast<float>(best) : static_cast<float>(best) * p[4];
+        if (score < kScoreThreshold) continue;
+
+        Detection d;
+        d.classId = cls.x;
+        d.score = score;
+        d.box = cv::Rect2d((p[0] - p[2] / 2) / scale, (p[1] - p[3] / 2) / scale, p[2] / scale, p[3] / scale);
+        found.push_back(d);
+        // Offset per class so NMS only suppresses within a class
+        nmsBoxes.emplace_back(cvRound(p[0] - p[2] / 2) + d.classId * 4 * kInputSize, cvRound(p[1] - p[3] / 2),
+                              cvRound(p[2]), cvRound(p[3]));
+        scores.push_back(score);
+    }
+
+    std::vector<int> keep;
+    cv::dnn::NMSBoxes(nmsBoxes, scores, kScoreThreshold, kNmsThreshold, keep);
+    std::vector<Detection> kept;
+    kept.reserve(keep.size());
+    for (int i : keep) kept.push_back(found[i]);
+    return kept;
+}
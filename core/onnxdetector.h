@@ -0,0 +1,49 @@
+#ifndef ONNXDETECTOR_H
+#define ONNXDETECTOR_H
+
+#include <QString>
+#include <QStringList>
+
+#include <opencv2/dnn.hpp>
+#include <opencv2/opencv.hpp>
+
+#include <vector>
+
+// One detected object, in pixels of the image it was found in.
+struct Detection
+{
+    int classId = 0;
+    float score = 0.0f;
+    cv::Rect2d box;
+};
+
+// YOLO-style ONNX detector on cv::dnn's CPU backend. Both common output
+// layouts are understood: [N, 5 + classes] (YOLOv5) and [4 + classes, N]
+// (YOLOv8). Class names come from <model>.names or classes.txt next to the
+// model, one per line. Not thread-safe.
+class OnnxDetector
+{
+public:
+    static constexpr int kInputSize = 640;          // letterboxed square input
+    static constexpr float kScoreThreshold = 0.35f;
+    static constexpr float kNmsThreshold = 0.45f;
+
+    bool load(const QString &path, QString *error = nullptr);
+    bool isLoaded() const { return !net_.empty(); }
+    const QString &path() const { return path_; }
+    QString className(int id) const;
+
+    // One forward pass for the whole batch when the model has a dynamic
+    // batch dimension, otherwise one per image.
+    std::vector<std::vector<Detection>> detect(const std::vector<cv::Mat> &images);
+
+private:
+    std::vector<Detection> parse(const cv::Mat &rows, bool transposed, double scale) const;
+
+    cv::dnn::Net net_;
+    QString path_;
+    QStringList classes_;
+    bool batched_ = true;       // cleared after the first rejected batch
+};
+
+#endif // ONNXDETECTOR_H
@@ -0,0 +1,57 @@
+#include "opencvdecoder.h"
+#include "videotimeline.h"
+
+bool OpenCvDecoder::open(const QString &path, const DecodeOptions &opt)
+{
+    if (cap_.isOpened()) cap_.release();
+    return openCapture(cap_, path, opt);
+}
+
+QString OpenCvDecoder::backendName() const
+{
+    if (!cap_.isOpened()) return QString();
+    return QString::fromStdString(cap_.getBackendName());
+}
+
+double OpenCvDecoder::nominalFps() const
+{
+    return cap_.get(cv::CAP_PROP_FPS);
+}
+
+int OpenCvDecoder::frameCountHint() const
+{
+    return static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_COUNT));
+}
+
+cv::Size OpenCvDecoder::frameSize() const
+{
+    return cv::Size(static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_WIDTH)),
+                    static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_HEIGHT)));
+}
+
+QString OpenCvDecoder::codecName() const
+{
+    // FOURCC packed little-endian into the double
+    const int fourcc = static_cast<int>(cap_.get(cv::CAP_PROP_FOURCC));
+    if (fourcc == 0) return QString();
+    const char c[] = {char(fourcc & 0xff), char((fourcc >> 8) & 0xff),
+                      char((fourcc >> 16) & 0xff), char((fourcc >> 24) & 0xff)};
+    return QString::fromLatin1(c, 4).trimmed();
+}
+
+bool OpenCvDecoder::grab(double &ptsMs)
+{
+    if (!cap_.grab()) return false;
+    ptsMs = cap_.get(cv::CAP_PROP_POS_MSEC);
+    return true;
+}
+
+bool OpenCvDecoder::retrieve(cv::Mat &bgr)
+{
+    return cap_.retrieve(bgr);
+}
+
+double OpenCvDecoder::seekAndGrab(double targetMs)
+{
+    return grabAtPts(cap_, targetMs);
+}
@@ -0,0 +1,28 @@
+#ifndef OPENCVDECODER_H
+#define OPENCVDECODER_H
+
+#include <opencv2/videoio.hpp>
+
+#include "framedecoder.h"
+
+// FrameDecoder over cv::VideoCapture (any backend OpenCV was built with).
+class OpenCvDecoder : public FrameDecoder
+{
+public:
+    bool open(const QString &path, const DecodeOptions &opt) override;
+    bool isOpen() const override { return cap_.isOpened(); }
+    QString backendName() const override;
+    double nominalFps() const override;
+    int frameCountHint() const override;
+    cv::Size frameSize() const override;
+    QString codecName() const override;
+
+    bool grab(double &ptsMs) override;
+    bool retrieve(cv::Mat &bgr) override;
+    double seekAndGrab(double targetMs) override;
+
+private:
+    cv::VideoCapture cap_;
+};
+
+#endif // OPENCVDECODER_H
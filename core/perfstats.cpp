@@ -0,0 +1,93 @@
+#include "perfstats.h"
+
+#include <algorithm>
+
+PerfStats::PerfStats()
+{
+    clock_.start();
+}
+
+const char *PerfStats::stageName(Stage s)
+{
+    switch (s)
+    {
+    case Decode:    return "decode";
+    case ToDisplay: return "display";
+    case Upload:    return "upload";
+    case Paint:     return "paint";
+    case Save:      return "save";
+    default:        return "?";
+    }
+}
+
+void PerfStats::add(Stage s, double ms)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring &r = rings_[s];
+    if (static_cast<int>(r.samples.size()) < kWindow)
+        r.samples.push_back(ms);
+    else
+        r.samples[r.next] = ms;
+    r.next = (r.next + 1) % kWindow;
+}
+
+void PerfStats::frameShown()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const qint64 now = clock_.elapsed();
+    shownAt_.push_back(now);
+    while (now - shownAt_.front() > 1000)
+        shownAt_.pop_front();
+}
+
+void PerfStats::frameDropped()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++dropped_;
+}
+
+void PerfStats::reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Ring &r : rings_) r = Ring();
+    shownAt_.clear();
+    dropped_ = 0;
+}
+
+PerfStats::Summary PerfStats::summary(Stage s) const
+{
+    std::vector<double> v;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        v = rings_[s].samples;
+    }
+
+    Summary out;
+    out.samples = static_cast<int>(v.size());
+    if (v.empty()) return out;
+
+    auto pct = [&v](double q) {
+        const size_t k = std::min(v.size() - 1, static_cast<size_t>(q * (v.size() - 1) + 0.5));
+        std::nth_element(v.begin(), v.begin() + k, v.end());
+        return v[k];
+    };
+    out.p50 = pct(0.50);
+    out.p95 = pct(0.95);
+    out.p99 = pct(0.99);
+    return out;
+}
+
+double PerfStats::effectiveFps() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const qint64 now = clock_.elapsed();
+    while (!shownAt_.empty() && now - shownAt_.front() > 1000)
+        shownAt_.pop_front();
+    return static_cast<double>(shownAt_.size());
+}
+
+qint64 PerfStats::droppedFrames() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
@@ -0,0 +1,71 @@
+#ifndef PERFSTATS_H
+#define PERFSTATS_H
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <array>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// Rolling timings of the frame pipeline for the performance HUD.
+// add() is thread-safe because saves finish on the encoder pool.
+class PerfStats
+{
+public:
+    // ToDisplay: resize and YUV/BGR -> RGB in one pass at the shown size;
+    // Upload: QImage -> QPixmap
+    enum Stage { Decode, ToDisplay, Upload, Paint, Save, StageCount };
+
+    struct Summary
+    {
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        int samples = 0;
+    };
+
+    PerfStats();
+
+    static const char *stageName(Stage s);
+
+    void add(Stage s, double ms);
+    void frameShown();
+    void frameDropped();
+    void reset();
+
+    Summary summary(Stage s) const;
+    double effectiveFps() const;    // frames shown during the last second
+    qint64 droppedFrames() const;
+
+private:
+    static constexpr int kWindow = 240;     // samples kept per stage
+
+    struct Ring
+    {
+        std::vector<double> samples;
+        int next = 0;
+    };
+
+    mutable std::mutex mutex_;
+    std::array<Ring, StageCount> rings_;
+    QElapsedTimer clock_;
+    mutable std::deque<qint64> shownAt_;    // ms stamps within the last second
+    qint64 dropped_ = 0;
+};
+
+// Adds the lifetime of the scope to one stage.
+class PerfScope
+{
+public:
+    PerfScope(PerfStats &stats, PerfStats::Stage stage) : stats_(stats), stage_(stage) { timer_.start(); }
+    ~PerfScope() { stats_.add(stage_, timer_.nsecsElapsed() / 1e6); }
+
+private:
+    PerfStats &stats_;
+    PerfStats::Stage stage_;
+    QElapsedTimer timer_;
+};
+
+#endif // PERFSTATS_H
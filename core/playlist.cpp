@@ -0,0 +1,49 @@
+#include "playlist.h"
+
+#include <QCollator>
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+
+const QStringList &Playlist::nameFilters()
+{
+    static const QStringList filters = {"*.mp4", "*.avi", "*.mkv", "*.mov", "*.m4v", "*.webm"};
+    return filters;
+}
+
+bool Playlist::setFolder(const QString &dir)
+{
+    clear();
+    QDir d(dir);
+    if (!d.exists()) return false;
+
+    QStringList names = d.entryList(nameFilters(), QDir::Files | QDir::Readable);
+    QCollator collator;
+    collator.setNumericMode(true);
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    std::sort(names.begin(), names.end(), collator);
+
+    dir_ = d.absolutePath();
+    for (const QString &name : names)
+        files_ << d.absoluteFilePath(name);
+    return !files_.isEmpty();
+}
+
+void Playlist::clear()
+{
+    dir_.clear();
+    files_.clear();
+    current_ = -1;
+}
+
+int Playlist::indexOf(const QString &path) const
+{
+    return files_.indexOf(QFileInfo(path).absoluteFilePath());
+}
+
+QString Playlist::neighbour(int delta) const
+{
+    if (current_ < 0) return QString();
+    return files_.value(current_ + delta);
+}
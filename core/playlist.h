@@ -0,0 +1,34 @@
+#ifndef PLAYLIST_H
+#define PLAYLIST_H
+
+#include <QString>
+#include <QStringList>
+
+// The video files of one folder in natural order ("clip2" before "clip10"),
+// for stepping through a folder of clips.
+class Playlist
+{
+public:
+    static const QStringList &nameFilters();    // *.mp4, *.mkv, ...
+
+    bool setFolder(const QString &dir);         // false if it has no videos
+    const QString &folder() const { return dir_; }
+    void clear();
+
+    int count() const { return files_.size(); }
+    bool isEmpty() const { return files_.isEmpty(); }
+    QString at(int index) const { return files_.value(index); }
+    int indexOf(const QString &path) const;
+
+    int current() const { return current_; }
+    void setCurrent(int index) { current_ = index; }
+    // Path delta entries away from the current one; empty past either end.
+    QString neighbour(int delta) const;
+
+private:
+    QString dir_;
+    QStringList files_;                         // absolute paths
+    int current_ = -1;
+};
+
+#endif // PLAYLIST_H
@@ -0,0 +1,117 @@
+#include "prelabeler.h"
+#include "trace.h"
+
+#include <algorithm>
+
+Prelabeler::Prelabeler()
+{
+    pool_.setMaxThreadCount(1);
+}
+
+Prelabeler::~Prelabeler()
+{
+    clear();
+    pool_.waitForDone();
+}
+
+bool Prelabeler::setModel(const QString &onnxPath, QString *error)
+{
+    std::shared_ptr<OnnxDetector> detector;
+    if (!onnxPath.isEmpty())
+    {
+        detector = std::make_shared<OnnxDetector>();
+        if (!detector->load(onnxPath, error)) return false;
+    }
+    // A batch already running finishes on the detector it took
+    std::lock_guard<std::mutex> lock(mutex_);
+    detector_ = std::move(detector);
+    queue_.clear();
+    return true;
+}
+
+bool Prelabeler::hasModel() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return detector_ != nullptr;
+}
+
+QString Prelabeler::modelPath() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return detector_ ? detector_->path() : QString();
+}
+
+void Prelabeler::submit(const QString &source, int frame, const cv::Mat &bgr, cv::Size fullSize)
+{
+    if (bgr.empty() || fullSize.empty()) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!detector_) return;
+    const bool queued = std::any_of(queue_.begin(), queue_.end(), [&](const Item &i) {
+        return i.frame == frame && i.source == source;
+    });
+    if (queued) return;
+
+    queue_.push_back({source, frame, bgr, fullSize});
+    while (static_cast<int>(queue_.size()) > kMaxQueued)
+        queue_.pop_front();
+
+    if (!draining_)
+    {
+        draining_ = true;
+        pool_.start([this]() { drain(); });
+    }
+}
+
+void Prelabeler::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.clear();
+}
+
+void Prelabeler::drain()
+{
+    VDT_TRACE_THREAD("prelabel");
+    for (;;)
+    {
+        std::vector<Item> batch;
+        std::shared_ptr<OnnxDetector> detector;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (queue_.empty() || !detector_)
+            {
+                draining_ = false;
+                return;
+            }
+            while (static_cast<int>(batch.size()) < kBatch && !queue_.empty())
+            {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+            detector = detector_;
+        }
+
+        std::vector<cv::Mat> images;
+        images.reserve(batch.size());
+        for (const Item &i : batch) images.push_back(i.bgr);
+        const std::vector<std::vector<Detection>> found = detector->detect(images);
+
+        for (size_t n = 0; n < batch.size(); ++n)
+        {
+            const Item &item = batch[n];
+            const double sx = static_cast<double>(item.fullSize.width)  / item.bgr.cols;
+            const double sy = static_cast<double>(item.fullSize.height) / item.bgr.rows;
+            const cv::Rect2d frameRect(0, 0, item.fullSize.width, item.fullSize.height);
+
+            std::vector<Annotation> boxes;
+            for (const Detection &d : found[n])
+            {
+                Annotation a;
+                a.label = detector->className(d.classId);
+                a.box = cv::Rect2d(d.box.x * sx, d.box.y * sy, d.box.width * sx, d.box.height * sy) & frameRect;
+                if (!a.box.empty()) boxes.push_back(a);
+            }
+            if (done_) done_(item.source, item.frame, boxes);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#ifndef PRELABELER_H
+#define PRELABELER_H
+
+#include <QString>
+#include <QThreadPool>
+
+#include <opencv2/opencv.hpp>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "annotations.h"
+#include "onnxdetector.h"
+
+// Runs an OnnxDetector off the GUI thread. Frames (display-sized copies are
+// plenty) queue up and are inferred in batches of up to kBatch on a one-thread
+// pool; when inference falls behind the oldest frames are dropped, so display
+// and playback never wait on the model.
+class Prelabeler
+{
+public:
+    static constexpr int kBatch = 4;
+    static constexpr int kMaxQueued = 8;
+
+    // Suggested boxes (track 0, labelled by class) in source frame pixels.
+    // Runs on the pool thread; set before the first submit().
+    using Done = std::function<void(const QString &source, int frame, const std::vector<Annotation> &boxes)>;
+
+    Prelabeler();
+    ~Prelabeler();              // drops queued frames, waits for the running batch
+
+    Prelabeler(const Prelabeler &) = delete;
+    Prelabeler &operator=(const Prelabeler &) = delete;
+
+    void setDone(Done done) { done_ = std::move(done); }
+
+    bool setModel(const QString &onnxPath, QString *error = nullptr);   // empty = off
+    bool hasModel() const;
+    QString modelPath() const;
+
+    // bgr is kept until inferred: it must not be written to afterwards.
+    void submit(const QString &source, int frame, const cv::Mat &bgr, cv::Size fullSize);
+    void clear();               // drops queued frames
+
+private:
+    struct Item
+    {
+        QString source;
+        int frame = 0;
+        cv::Mat bgr;
+        cv::Size fullSize;
+    };
+    void drain();
+
+    mutable std::mutex mutex_;
+    std::shared_ptr<OnnxDetector> detector_;
+    std::deque<Item> queue_;
+    bool draining_ = false;
+    Done done_;
+    QThreadPool pool_;          // one thread: the net is not thread-safe
+};
+
+#endif // PRELABELER_H
@@ -0,0 +1,156 @@
+#include "progressstore.h"
+#include "fileutil.h"
+#include "trace.h"
+
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+namespace {
+
+QByteArray recordLine(const QString &key, const VideoProgress &p)
+{
+    QJsonObject o;
+    o["video"] = key;
+    o["frame"] = p.lastFrame;
+    o["pts_ms"] = p.lastPtsMs;
+    o["saved"] = p.savedFrames;
+    o["done"] = p.done;
+    return QJsonDocument(o).toJson(QJsonDocument::Compact) + '\n';
+}
+
+} // namespace
+
+ProgressStore::~ProgressStore()
+{
+    close();
+}
+
+QString ProgressStore::keyFor(const QString &video)
+{
+    return QFileInfo(video).absoluteFilePath();
+}
+
+bool ProgressStore::open(const QString &path)
+{
+    close();
+    entries_.clear();
+    lines_ = 0;
+    done_ = 0;
+
+    log_.setFileName(path);
+    if (log_.open(QIODevice::ReadOnly))
+    {
+        VDT_TRACE_SCOPE("progress replay");
+        qint64 complete = 0;                    // end of the last whole line
+        while (!log_.atEnd())
+        {
+            const QByteArray line = log_.readLine();
+            if (!line.endsWith('\n')) break;    // torn write: the change was lost, not corrupted
+            complete = log_.pos();
+            const QJsonObject o = QJsonDocument::fromJson(line).object();
+            const QString key = o.value("video").toString();
+            if (key.isEmpty()) continue;
+
+            VideoProgress p;
+            p.lastFrame = o.value("frame").toInt();
+            p.lastPtsMs = o.value("pts_ms").toDouble();
+            p.savedFrames = o.value("saved").toInt();
+            p.done = o.value("done").toBool();
+            put(key, p);
+            ++lines_;
+        }
+        const qint64 size = log_.size();
+        log_.close();
+        // Cut the fragment off, or the next record would be glued onto it
+        if (complete < size && !log_.resize(complete)) return false;
+    }
+
+    if (lines_ > 2 * entries_.size() + kCompactSlack) return compact();
+    return log_.open(QIODevice::WriteOnly | QIODevice::Append);
+}
+
+void ProgressStore::close()
+{
+    if (!log_.isOpen()) return;
+    syncFile(log_);
+    log_.close();
+}
+
+bool ProgressStore::contains(const QString &video) const
+{
+    return entries_.contains(keyFor(video));
+}
+
+VideoProgress ProgressStore::get(const QString &video) const
+{
+    return entries_.value(keyFor(video));
+}
+
+void ProgressStore::put(const QString &key, const VideoProgress &p)
+{
+    auto it = entries_.find(key);
+    if (it != entries_.end() && it->done) --done_;
+    entries_.insert(key, p);
+    if (p.done) ++done_;
+}
+
+bool ProgressStore::append(const QString &key, const VideoProgress &p)
+{
+    if (!log_.isOpen()) return false;
+    const QByteArray line = recordLine(key, p);
+    // Flushed per record: survives an application crash, the OS does the rest
+    const bool ok = log_.write(line) == line.size() && log_.flush();
+    ++lines_;
+    return ok;
+}
+
+void ProgressStore::setPosition(const QString &video, int frame, double ptsMs)
+{
+    const QString key = keyFor(video);
+    VideoProgress p = entries_.value(key);
+    if (entries_.contains(key) && p.lastFrame == frame) return;
+    p.lastFrame = frame;
+    p.lastPtsMs = ptsMs;
+    put(key, p);
+    append(key, p);
+}
+
+void ProgressStore::addSaved(const QString &video, int count)
+{
+    const QString key = keyFor(video);
+    VideoProgress p = entries_.value(key);
+    p.savedFrames += count;
+    put(key, p);
+    append(key, p);
+}
+
+void ProgressStore::setDone(const QString &video, bool done)
+{
+    const QString key = keyFor(video);
+    VideoProgress p = entries_.value(key);
+    if (entries_.contains(key) && p.done == done) return;
+    p.done = done;
+    put(key, p);
+    append(key, p);
+}
+
+bool ProgressStore::compact()
+{
+    VDT_TRACE_SCOPE("progress compact");
+    const QString path = log_.fileName();
+    close();
+
+    // Current state only, swapped in atomically: a crash leaves either log
+    QSaveFile f(path);
+    if (f.open(QIODevice::WriteOnly))
+    {
+        for (auto it = entries_.cbegin(); it != entries_.cend(); ++it)
+            f.write(recordLine(it.key(), it.value()));
+        if (f.commit()) lines_ = entries_.size();
+    }
+
+    log_.setFileName(path);
+    return log_.open(QIODevice::WriteOnly | QIODevice::Append);
+}
@@ -0,0 +1,60 @@
+#ifndef PROGRESSSTORE_H
+#define PROGRESSSTORE_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+
+// Review state of one video.
+struct VideoProgress
+{
+    int lastFrame = 0;          // where review stopped
+    double lastPtsMs = 0.0;
+    int savedFrames = 0;
+    bool done = false;
+};
+
+// Review progress across many videos, keyed by absolute path.
+// Every change appends one JSON line with the video's full state to
+// progress.jsonl, so an update costs one small write however many videos are
+// tracked. Loading replays the log into a hash; a torn last line (crash mid
+// write) is cut off before appending resumes. The log is compacted to one line per video when it has
+// grown well past that.
+class ProgressStore
+{
+public:
+    ProgressStore() = default;
+    ~ProgressStore();
+
+    ProgressStore(const ProgressStore &) = delete;
+    ProgressStore &operator=(const ProgressStore &) = delete;
+
+    bool open(const QString &path);
+    void close();                               // syncs
+    bool isOpen() const { return log_.isOpen(); }
+
+    bool contains(const QString &video) const;
+    VideoProgress get(const QString &video) const;
+    int count() const { return entries_.size(); }
+    int doneCount() const { return done_; }
+
+    void setPosition(const QString &video, int frame, double ptsMs);
+    void addSaved(const QString &video, int count = 1);
+    void setDone(const QString &video, bool done);
+
+    bool compact();
+
+private:
+    static constexpr int kCompactSlack = 1000;  // stale lines tolerated before compacting
+
+    static QString keyFor(const QString &video);
+    void put(const QString &key, const VideoProgress &p);
+    bool append(const QString &key, const VideoProgress &p);
+
+    QFile log_;
+    QHash<QString, VideoProgress> entries_;
+    int lines_ = 0;                             // records in the log, stale included
+    int done_ = 0;
+};
+
+#endif // PROGRESSSTORE_H
@@ -0,0 +1,75 @@
+#include "proxyfile.h"
+#include "fileutil.h"
+#include "trace.h"
+#include "videosource.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+QString proxyFilePathFor(const QString &source, const QString &cacheDir)
+{
+    return QDir(cacheDir).filePath(QString("%1_%2.avi").arg(sourceCacheKey(source)).arg(kProxyFileWidth));
+}
+
+bool buildProxyFile(const QString &source, const QString &target, const DecodeOptions &opt,
+                    const std::atomic_bool *cancel, const std::function<void(int, int)> &progress)
+{
+    VDT_TRACE_SCOPE("build proxy file");
+
+    VideoSource src;
+    src.setOptions(opt);
+    if (!src.open(source)) return false;
+    // Width-bound only: tall sources keep their aspect
+    src.setProxySize(cv::Size(kProxyFileWidth, kProxyFileWidth * 4));
+
+    QDir().mkpath(QFileInfo(target).absolutePath());
+    const QString part = target.left(target.size() - QFileInfo(target).suffix().size() - 1) + ".part.avi";
+    QFile::remove(part);
+
+    cv::VideoWriter writer;
+    const int total = src.frameCount();
+    int done = 0;
+    bool ok = true;
+    DecodedFrame f;
+    while (src.readNext(f))
+    {
+        if (cancel && cancel->load())
+        {
+            ok = false;
+            break;
+        }
+        if (!f.ensureBgr() && f.bgr.empty())
+        {
+            ok = false;
+            break;
+        }
+
+        if (!writer.isOpened())
+        {
+            // MJPEG: every frame is a keyframe, so any seek is one decode
+            writer.open(part.toStdString(), cv::VideoWriter::fourcc('M', 'J', 'P', 'G'),
+                        src.nominalFps(), f.bgr.size());
+            if (!writer.isOpened())
+            {
+                ok = false;
+                break;
+            }
+            writer.set(cv::VIDEOWRITER_PROP_QUALITY, 85);
+        }
+        writer.write(f.bgr);
+
+        ++done;
+        if (progress && done % 100 == 0) progress(done, total);
+    }
+    writer.release();
+
+    ok = ok && done > 0;
+    if (ok)
+    {
+        QFile::remove(target);
+        ok = QFile::rename(part, target);
+    }
+    if (!ok) QFile::remove(part);
+    return ok;
+}
@@ -0,0 +1,25 @@
+#ifndef PROXYFILE_H
+#define PROXYFILE_H
+
+#include <QString>
+
+#include <atomic>
+#include <functional>
+
+#include "decodebackend.h"
+
+// Navigation proxies: an all-intra MJPEG copy of a large video, one frame per
+// source frame, so scrubbing never waits on long GOPs or 4K+ decodes. Saves
+// still read the original (VideoSource::retrieveFull()).
+constexpr int kProxyFileWidth = 960;
+
+// Cache file for source under cacheDir; changes when the source does.
+QString proxyFilePathFor(const QString &source, const QString &cacheDir);
+
+// Writes target via a temporary file, so an existing target is always
+// complete. progress(done, total) is called from the building thread.
+bool buildProxyFile(const QString &source, const QString &target, const DecodeOptions &opt,
+                    const std::atomic_bool *cancel = nullptr,
+                    const std::function<void(int, int)> &progress = {});
+
+#endif // PROXYFILE_H
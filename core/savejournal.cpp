@@ -0,0 +1,240 @@
+#include "savejournal.h"
+#include "datasetindex.h"
+#include "fileutil.h"
+#include "trace.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QTextStream>
+
+namespace {
+
+// Every folder a save writes into: the directory and each "<w>px/", and
+// below both the shards ("0012/") and content-hash folders ("ab/cd/")
+QStringList saveFolders(const QString &saveDir)
+{
+    QDir dir(saveDir);
+    QStringList roots = {saveDir};
+    for (const QString &sub : dir.entryList({"*px"}, QDir::Dirs | QDir::NoDotAndDotDot))
+        roots << dir.filePath(sub);
+
+    static const QRegularExpression hexByte("^[0-9a-f]{2}$");
+    QStringList folders;
+    for (const QString &root : roots)
+    {
+        folders << root;
+        const QDir r(root);
+        for (const QString &a : r.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        {
+            if (DatasetIndex::isShardName(a)) folders << r.filePath(a);
+            if (!hexByte.match(a).hasMatch()) continue;
+            const QDir ad(r.filePath(a));
+            for (const QString &b : ad.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+                if (hexByte.match(b).hasMatch()) folders << ad.filePath(b);
+        }
+    }
+    return folders;
+}
+
+} // namespace
+
+SaveJournal::~SaveJournal()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    closeLocked();
+}
+
+QString SaveJournal::sessionFileName()
+{
+    static const QString name = QString(".vdt_journal-%1-%2").arg(QSysInfo::machineHostName())
+                                    .arg(QCoreApplication::applicationPid());
+    return name;
+}
+
+void SaveJournal::closeLocked()
+{
+    if (!file_.isOpen()) return;
+    syncFile(file_);
+    file_.close();
+    // Nothing left to recover: a clean session leaves no journal behind
+    if (open_.isEmpty()) file_.remove();
+}
+
+bool SaveJournal::appendLocked(const QString &saveDir, char kind, const QString &fileName)
+{
+    // Reopened after a directory switch, or after recover() removed the file
+    if (dir_ != saveDir || !file_.isOpen() || !file_.exists())
+    {
+        closeLocked();
+        dir_ = saveDir;
+        open_.clear();
+        records_ = 0;
+        file_.setFileName(QDir(saveDir).filePath(sessionFileName()));
+        if (!file_.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) return false;
+    }
+
+    const QByteArray line = QByteArray(1, kind) + ' ' + fileName.toUtf8() + '\n';
+    // Durable before any file of the save appears / before it counts as done
+    if (file_.write(line) != line.size() || !syncFile(file_)) return false;
+    ++records_;
+
+    if (open_.isEmpty() && records_ > kTruncateAfter)
+    {
+        // Everything committed: the history is no longer needed
+        file_.resize(0);
+        records_ = 0;
+    }
+    return true;
+}
+
+bool SaveJournal::begin(const QString &saveDir, const QString &fileName)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool ok = appendLocked(saveDir, 'B', fileName);
+    if (ok) open_.insert(fileName);
+    return ok;
+}
+
+bool SaveJournal::commit(const QString &saveDir, const QString &fileName)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_.remove(fileName);
+    return appendLocked(saveDir, 'C', fileName);
+}
+
+void SaveJournal::abort(const QString &saveDir, const QString &fileName)
+{
+    removeSaveFiles(saveDir, fileName);
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_.remove(fileName);
+    appendLocked(saveDir, 'C', fileName);   // nothing left on disk to recover
+}
+
+QString SaveJournal::partPathFor(const QString &path)
+{
+    return QString("%1.%2.part").arg(path).arg(QRandomGenerator::global()->generate64(), 0, 16);
+}
+
+bool SaveJournal::writeAndSync(const QString &path, const char *data, qint64 size, bool keepExisting)
+{
+    if (keepExisting && QFile::exists(path)) return true;
+    const QString part = partPathFor(path);
+    QFile f(part);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    bool ok = f.write(data, size) == size && syncFile(f);
+    f.close();
+    ok = ok && f.error() == QFileDevice::NoError;
+
+    // Atomic replace, then the directory entry made durable: otherwise the
+    // commit record could survive a crash that the rename did not
+    if (ok && keepExisting && !moveFileNoReplace(part, path))
+    {
+        // Written by another save meanwhile; a failed move leaves no target
+        QFile::remove(part);
+        return QFile::exists(path);
+    }
+    ok = ok && (keepExisting || replaceFile(part, path)) && syncDirectory(QFileInfo(path).absolutePath());
+    if (!ok) QFile::remove(part);
+    return ok;
+}
+
+void SaveJournal::removeSaveFiles(const QString &saveDir, const QString &fileName)
+{
+    // Level 0 in the directory itself, smaller levels in "<w>px/"
+    QDir dir(saveDir);
+    QStringList paths = {dir.filePath(fileName)};
+    for (const QString &sub : dir.entryList({"*px"}, QDir::Dirs | QDir::NoDotAndDotDot))
+        paths << dir.filePath(sub + "/" + fileName);
+    // Annotation sidecars of level 0 (<image>.txt / .json)
+    const QString base = paths.first().left(paths.first().lastIndexOf('.'));
+    paths << base + ".txt" << base + ".json";
+    for (const QString &p : paths)
+    {
+        QFile::remove(p);
+        const QFileInfo fi(p);
+        for (const QString &part : fi.dir().entryList({fi.fileName() + ".*.part"}, QDir::Files))
+            QFile::remove(fi.dir().filePath(part));
+    }
+}
+
+QDateTime SaveJournal::directoryNow(const QString &saveDir)
+{
+    QFile probe(QDir(saveDir).filePath(".vdt_clock" + sessionFileName().mid(QString(".vdt_journal").size())));
+    if (!probe.open(QIODevice::WriteOnly)) return QDateTime::currentDateTime();
+    probe.write("\n");
+    probe.close();
+    const QDateTime now = QFileInfo(probe.fileName()).lastModified();
+    probe.remove();
+    return now.isValid() ? now : QDateTime::currentDateTime();
+}
+
+bool SaveJournal::isAbandoned(const QString &journalName, bool stale)
+{
+    // .vdt_journal-<host>-<pid>; host names may contain '-' themselves
+    const int dash = journalName.lastIndexOf('-');
+    const QString prefix = ".vdt_journal-";
+    if (dash <= prefix.size()) return stale;
+    const QString host = journalName.mid(prefix.size(), dash - prefix.size());
+    bool ok = false;
+    const qint64 pid = journalName.mid(dash + 1).toLongLong(&ok);
+    // Our machine: the session is gone exactly when its process is, however
+    // long it has been idle. Another one: only its age can tell.
+    if (ok && host == QSysInfo::machineHostName()) return !processAlive(pid);
+    return stale;
+}
+
+SaveJournal::Recovery SaveJournal::recover(const QString &saveDir)
+{
+    VDT_TRACE_SCOPE("save journal recovery");
+    Recovery r;
+    QDir dir(saveDir);
+    if (saveDir.isEmpty() || !dir.exists()) return r;
+
+    // Ages by the file server's clock, not ours: a file touched just now
+    // tells what "now" is there
+    const QDateTime now = directoryNow(saveDir);
+    auto isStale = [&now](const QFileInfo &fi) { return fi.lastModified().msecsTo(now) > kStaleMs; };
+
+    const QFileInfoList journals = dir.entryInfoList({".vdt_journal-*"}, QDir::Files | QDir::Hidden);
+    for (const QFileInfo &fi : journals)
+    {
+        if (fi.fileName() == sessionFileName() || !isAbandoned(fi.fileName(), isStale(fi))) continue;
+        QFile journal(fi.absoluteFilePath());
+        if (!journal.open(QIODevice::ReadOnly | QIODevice::Text)) continue;
+
+        QHash<QString, bool> begun;     // name -> committed
+        QTextStream in(&journal);
+        while (!in.atEnd())
+        {
+            const QString line = in.readLine();
+            if (line.size() < 3 || line[1] != ' ') continue;    // torn last line
+            const QString name = line.mid(2);
+            if (line[0] == 'B') begun.insert(name, false);
+            else if (line[0] == 'C') begun.insert(name, true);
+        }
+        journal.close();
+
+        for (auto it = begun.cbegin(); it != begun.cend(); ++it)
+        {
+            if (it.value()) continue;
+            removeSaveFiles(saveDir, it.key());
+            ++r.removedSaves;
+        }
+        journal.remove();
+    }
+
+    // Leftovers of saves whose begin record never reached the disk, and of
+    // content-named saves, which are never journaled
+    for (const QString &d : saveFolders(saveDir))
+    {
+        for (const QFileInfo &part : QDir(d).entryInfoList({"*.part"}, QDir::Files))
+            if (isStale(part) && QFile::remove(part.absoluteFilePath())) ++r.removedParts;
+    }
+    return r;
+}
@@ -0,0 +1,75 @@
+#ifndef SAVEJOURNAL_H
+#define SAVEJOURNAL_H
+
+#include <QDateTime>
+#include <QFile>
+#include <QSet>
+#include <QString>
+
+#include <mutex>
+
+// Write-ahead log of saves in one save directory, one per session
+// (.vdt_journal-<host>-<pid>, removed on a clean exit) since several
+// processes may save into a shared directory.
+// A save is "B <name>" before its first file is written and "C <name>" once
+// every level is on disk under its final name. Files are written as
+// "<name>.<nonce>.part", synced, renamed and the directory synced, so a crash
+// leaves either .part leftovers or a begun-but-uncommitted save; recover()
+// removes both. Content-named saves are not journaled: a file under its hash
+// name is complete by construction and may belong to another save.
+// Thread-safe: encoder threads share one instance.
+class SaveJournal
+{
+public:
+    // A save takes well under this; an older open record belongs to a dead session
+    static constexpr qint64 kStaleMs = 60 * 1000;
+
+    struct Recovery
+    {
+        int removedSaves = 0;   // begun, never committed
+        int removedParts = 0;   // stray .part files
+    };
+
+    SaveJournal() = default;
+    ~SaveJournal();
+
+    SaveJournal(const SaveJournal &) = delete;
+    SaveJournal &operator=(const SaveJournal &) = delete;
+
+    bool begin(const QString &saveDir, const QString &fileName);
+    bool commit(const QString &saveDir, const QString &fileName);
+    // A failed save: removes whatever it wrote and closes its record.
+    void abort(const QString &saveDir, const QString &fileName);
+
+    // Cleans up after crashed sessions: journals of processes on this machine
+    // that no longer run, of other machines once untouched for kStaleMs (by
+    // the file server's clock), and .part files untouched that long, so live
+    // sessions sharing the directory are safe.
+    static Recovery recover(const QString &saveDir);
+
+    // Temp name for a file of a save, unique per call: writers of the same
+    // name never share one, so a failing writer only removes its own.
+    static QString partPathFor(const QString &path);
+    // Writes path through a synced .part and an atomic rename. keepExisting
+    // (content names) never replaces a file already there and counts it as
+    // written: same name, same bytes.
+    static bool writeAndSync(const QString &path, const char *data, qint64 size, bool keepExisting = false);
+
+private:
+    static constexpr int kTruncateAfter = 1000;     // records, once nothing is open
+
+    static QString sessionFileName();
+    static QDateTime directoryNow(const QString &saveDir);
+    static bool isAbandoned(const QString &journalName, bool stale);
+    bool appendLocked(const QString &saveDir, char kind, const QString &fileName);
+    void closeLocked();
+    static void removeSaveFiles(const QString &saveDir, const QString &fileName);
+
+    std::mutex mutex_;
+    QFile file_;                // journal of the directory saved into last
+    QString dir_;
+    QSet<QString> open_;        // begun, not yet committed (in dir_)
+    int records_ = 0;
+};
+
+#endif // SAVEJOURNAL_H
@@ -0,0 +1,116 @@
+#include "trace.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+
+QElapsedTimer &traceClock()
+{
+    static QElapsedTimer clock = [] { QElapsedTimer c; c.start(); return c; }();
+    return clock;
+}
+
+// Small stable ids read better in the viewer than native thread handles
+int currentTid()
+{
+    static std::atomic_int nextTid{1};
+    thread_local int tid = nextTid.fetch_add(1);
+    return tid;
+}
+
+} // namespace
+
+Tracer &Tracer::instance()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+Tracer::Tracer()
+{
+    traceClock();
+}
+
+int64_t Tracer::nowUs() const
+{
+    return traceClock().nsecsElapsed() / 1000;
+}
+
+void Tracer::start()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    events_.clear();
+    events_.reserve(1 << 16);
+    recording_.store(true);
+}
+
+void Tracer::setThreadName(const char *name)
+{
+    const int tid = currentTid();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &t : threadNames_)
+    {
+        if (t.first == tid)
+        {
+            t.second = QString::fromUtf8(name);
+            return;
+        }
+    }
+    threadNames_.emplace_back(tid, QString::fromUtf8(name));
+}
+
+void Tracer::addSpan(const char *name, int64_t startUs, int64_t durUs)
+{
+    const int tid = currentTid();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!recording_.load(std::memory_order_relaxed) || events_.size() >= kMaxEvents) return;
+    events_.push_back({name, startUs, durUs, tid});
+}
+
+bool Tracer::stopAndWrite(const QString &path)
+{
+    std::vector<Event> events;
+    std::vector<std::pair<int, QString>> names;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        recording_.store(false);
+        events.swap(events_);
+        names = threadNames_;
+    }
+
+    QJsonArray out;
+    for (const auto &t : names)
+    {
+        QJsonObject m;
+        m["name"] = "thread_name";
+        m["ph"] = "M";
+        m["pid"] = 1;
+        m["tid"] = t.first;
+        m["args"] = QJsonObject{{"name", t.second}};
+        out.append(m);
+    }
+    for (const Event &e : events)
+    {
+        QJsonObject o;
+        o["name"] = QString::fromLatin1(e.name);
+        o["ph"] = "X";
+        o["pid"] = 1;
+        o["tid"] = e.tid;
+        o["ts"] = static_cast<qint64>(e.startUs);
+        o["dur"] = static_cast<qint64>(e.durUs);
+        out.append(o);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = out;
+    root["displayTimeUnit"] = "ms";
+
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return f.error() == QFileDevice::NoError;
+}
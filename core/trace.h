@@ -0,0 +1,80 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Frame pipeline tracing, exported as Chrome trace JSON (opens in Perfetto /
+// chrome://tracing). Compiled out entirely unless VDT_ENABLE_TRACING is set;
+// when compiled in but not recording, a span costs one relaxed atomic load.
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class Tracer
+{
+public:
+    static Tracer &instance();
+
+    bool isRecording() const { return recording_.load(std::memory_order_relaxed); }
+    void start();
+    // Stops recording and writes everything captured so far.
+    bool stopAndWrite(const QString &path);
+
+    // Shows up as the thread's track name in the viewer.
+    void setThreadName(const char *name);
+
+    void addSpan(const char *name, int64_t startUs, int64_t durUs);
+    int64_t nowUs() const;
+
+private:
+    Tracer();
+
+    struct Event
+    {
+        const char *name;       // string literal, never freed
+        int64_t startUs;
+        int64_t durUs;
+        int tid;
+    };
+
+    static constexpr size_t kMaxEvents = 2'000'000;
+
+    std::atomic_bool recording_{false};
+    std::mutex mutex_;
+    std::vector<Event> events_;
+    std::vector<std::pair<int, QString>> threadNames_;
+};
+
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name)
+        : name_(Tracer::instance().isRecording() ? name : nullptr)
+        , startUs_(name_ ? Tracer::instance().nowUs() : 0) {}
+    ~TraceScope()
+    {
+        if (name_) Tracer::instance().addSpan(name_, startUs_, Tracer::instance().nowUs() - startUs_);
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_;
+    int64_t startUs_;
+};
+
+#define VDT_TRACE_CONCAT_(a, b) a##b
+#define VDT_TRACE_CONCAT(a, b) VDT_TRACE_CONCAT_(a, b)
+
+#if defined(VDT_ENABLE_TRACING) && VDT_ENABLE_TRACING
+#define VDT_TRACE_SCOPE(name) TraceScope VDT_TRACE_CONCAT(vdtTraceScope_, __LINE__)(name)
+#define VDT_TRACE_THREAD(name) Tracer::instance().setThreadName(name)
+#else
+#define VDT_TRACE_SCOPE(name) do {} while (0)
+#define VDT_TRACE_THREAD(name) do {} while (0)
+#endif
+
+#endif // TRACE_H
@@ -0,0 +1,23 @@
+#include "videoprefetch.h"
+#include "trace.h"
+
+std::shared_ptr<PreparedVideo> prepareVideo(const QString &path, const DecodeOptions &opt,
+                                            const QString &timelineCacheDir,
+                                            const std::atomic_bool *cancel)
+{
+    VDT_TRACE_SCOPE("prefetch video");
+    auto p = std::make_shared<PreparedVideo>();
+    p->path = path;
+    p->options = opt;
+    p->source.setOptions(opt);
+    if (!p->source.open(path)) return nullptr;
+    if (cancel && cancel->load()) return nullptr;
+
+    VideoTimeline t = VideoTimeline::load(timelineCachePathFor(path, timelineCacheDir));
+    if (!t.isEmpty()) p->source.setTimeline(std::move(t));
+
+    // Full resolution: the first frame is what the user rests on
+    if (!p->source.seekToIndex(0, p->first)) return nullptr;
+    if (cancel && cancel->load()) return nullptr;
+    return p;
+}
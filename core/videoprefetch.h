@@ -0,0 +1,27 @@
+#ifndef VIDEOPREFETCH_H
+#define VIDEOPREFETCH_H
+
+#include <QString>
+
+#include <atomic>
+#include <memory>
+
+#include "videosource.h"
+
+// A video opened ahead of time on a worker thread: container probed, decoder
+// up, frame 0 decoded and the PTS table loaded if it was cached. Handing the
+// source over to the GUI thread makes switching to it instant.
+struct PreparedVideo
+{
+    QString path;
+    DecodeOptions options;      // what source was opened with
+    VideoSource source;
+    DecodedFrame first;
+};
+
+// Null when the file cannot be opened or cancel was set.
+std::shared_ptr<PreparedVideo> prepareVideo(const QString &path, const DecodeOptions &opt,
+                                            const QString &timelineCacheDir,
+                                            const std::atomic_bool *cancel = nullptr);
+
+#endif // VIDEOPREFETCH_H
@@ -0,0 +1,281 @@
+#include "videosource.h"
+#include "displayconvert.h"
+#include "trace.h"
+
+#include <algorithm>
+
+namespace {
+
+// Same limit as FrameCache: beyond this a seek is cheaper than decoding through
+constexpr int kMaxSkipAhead = 12;
+
+} // namespace
+
+cv::Size DecodedFrame::size() const
+{
+    if (isProxy()) return fullSize;
+    if (!bgr.empty()) return bgr.size();
+    return native ? native->size() : cv::Size();
+}
+
+bool DecodedFrame::ensureBgr()
+{
+    if (isProxy()) return false;
+    if (!bgr.empty()) return true;
+    VDT_TRACE_SCOPE("native to BGR");
+    bgr.allocator = &FramePool::instance();
+    return native && native->toBgr(bgr);
+}
+
+bool DecodedFrame::toDisplay(const QSize &size, QImage &rgb32) const
+{
+    if (native && bgr.empty()) return native->toDisplay(size, rgb32);
+    return matToDisplayImage(bgr, size, rgb32);
+}
+
+bool VideoSource::open(const QString &path)
+{
+    close();
+
+    decoder_ = createDecoder(options_);
+    if (!decoder_->open(path, options_))
+    {
+        decoder_.reset();
+        return false;
+    }
+
+    path_ = path;
+    fps_ = decoder_->nominalFps();
+    if (fps_ <= 0.0) fps_ = 30.0;
+    fullSize_ = decoder_->frameSize();
+
+    // Nominal FPS is only a placeholder until the real PTS table is scanned
+    timeline_ = VideoTimeline::fromConstantRate(decoder_->frameCountHint(), fps_);
+    lastIndex_ = -1;
+    fullIndex_ = -1;
+    return true;
+}
+
+QString VideoSource::backendName() const
+{
+    if (!isOpen()) return QString();
+    return decoder_->backendName();
+}
+
+void VideoSource::close()
+{
+    proxyFile_.reset();
+    decoder_.reset();
+    path_.clear();
+    timeline_ = VideoTimeline();
+    fullSize_ = cv::Size();
+    lastIndex_ = -1;
+    fullIndex_ = -1;
+}
+
+void VideoSource::setTimeline(VideoTimeline t)
+{
+    timeline_ = std::move(t);
+
+    // One proxy frame per source frame, or indices would drift
+    if (proxyFile_ && timeline_.isExact() && proxyTimeline_.frameCount() != timeline_.frameCount())
+        detachProxyFile();
+
+    // Keep the decoder positions meaningful under the new table
+    if (fullIndex_ >= 0) fullIndex_ = timeline_.indexAt(fullPts_);
+    if (lastIndex_ >= 0)
+    {
+        if (proxyFile_)
+            lastPts_ = timeline_.ptsAt(lastIndex_);
+        else
+            lastIndex_ = timeline_.indexAt(lastPts_);
+    }
+}
+
+bool VideoSource::attachProxyFile(const QString &path)
+{
+    if (!isOpen() || fullSize_.empty()) return false;
+
+    std::unique_ptr<FrameDecoder> dec = createDecoder(options_);
+    if (!dec->open(path, options_)) return false;
+    const int count = dec->frameCountHint();
+    if (count <= 0 || (timeline_.isExact() && count != timeline_.frameCount())) return false;
+
+    proxyFile_ = std::move(dec);
+    proxyTimeline_ = VideoTimeline::fromConstantRate(count, proxyFile_->nominalFps());
+    lastIndex_ = -1;    // the proxy decoder starts at the beginning
+    return true;
+}
+
+void VideoSource::detachProxyFile()
+{
+    if (!proxyFile_) return;
+    proxyFile_.reset();
+    // Navigation continues wherever the original decoder is
+    lastIndex_ = fullIndex_;
+    lastPts_ = fullPts_;
+}
+
+double VideoSource::navPtsFor(int index) const
+{
+    return proxyFile_ ? proxyTimeline_.ptsAt(index) : timeline_.ptsAt(index);
+}
+
+void VideoSource::landedAt(double pts)
+{
+    if (proxyFile_)
+    {
+        // Proxy timestamps are its own; the index is what the two share
+        lastIndex_ = proxyTimeline_.indexAt(pts);
+        lastPts_ = timeline_.ptsAt(lastIndex_);
+        return;
+    }
+    lastPts_ = pts;
+    lastIndex_ = timeline_.indexAt(pts);
+    fullPts_ = lastPts_;
+    fullIndex_ = lastIndex_;
+}
+
+bool VideoSource::retrieveFullFrom(FrameDecoder &dec, DecodedFrame &out)
+{
+    // Native pictures stay in decoder format; no full-res conversion here
+    out.native = dec.retrieveNative();
+    if (out.native) return true;
+
+    // Fresh Mat header on a pooled buffer: the previous frame may still be
+    // referenced by the cache or a save job
+    cv::Mat frame;
+    frame.allocator = &FramePool::instance();
+    if (!dec.retrieve(frame)) return false;
+    out.bgr = frame;
+    return true;
+}
+
+bool VideoSource::retrieveInto(DecodedFrame &out)
+{
+    VDT_TRACE_SCOPE("retrieve");
+    out.native.reset();
+    out.bgr.release();
+    out.fullSize = cv::Size();
+    out.ptsMs = lastPts_;
+    out.index = lastIndex_;
+
+    if (proxyFile_)
+    {
+        out.fullSize = fullSize_;
+        out.bgr.allocator = &FramePool::instance();
+        if (proxySize_.empty()) return proxyFile_->retrieve(out.bgr);
+        cv::Size proxyFull;
+        return proxyFile_->retrieveProxy(proxySize_, out.bgr, proxyFull);
+    }
+
+    if (!proxySize_.empty())
+    {
+        out.bgr.allocator = &FramePool::instance();
+        return decoder_->retrieveProxy(proxySize_, out.bgr, out.fullSize);
+    }
+    return retrieveFullFrom(*decoder_, out);
+}
+
+bool VideoSource::readNext(DecodedFrame &out)
+{
+    if (!isOpen()) return false;
+    double pts = 0.0;
+    {
+        VDT_TRACE_SCOPE("grab");
+        if (!nav()->grab(pts)) return false;
+    }
+    landedAt(pts);
+    return retrieveInto(out);
+}
+
+bool VideoSource::skipNext()
+{
+    if (!isOpen()) return false;
+    VDT_TRACE_SCOPE("grab (dropped)");
+    double pts = 0.0;
+    if (!nav()->grab(pts)) return false;
+    landedAt(pts);
+    return true;
+}
+
+bool VideoSource::seekToPts(double ptsMs, DecodedFrame &out)
+{
+    if (!isOpen()) return false;
+
+    const double pos = nav()->seekAndGrab(navPtsFor(timeline_.indexAt(ptsMs)));
+    if (pos < 0.0) return false;
+
+    landedAt(pos);
+    return retrieveInto(out);
+}
+
+bool VideoSource::retrieveOriginal(int index, DecodedFrame &out)
+{
+    VDT_TRACE_SCOPE("retrieve original");
+    const int gap = index - fullIndex_;
+    if (fullIndex_ < 0 || gap < 0 || gap > kMaxSkipAhead)
+    {
+        const double pos = decoder_->seekAndGrab(timeline_.ptsAt(index));
+        if (pos < 0.0) return false;
+        fullPts_ = pos;
+        fullIndex_ = timeline_.indexAt(pos);
+    }
+    while (fullIndex_ < index)
+    {
+        double pts = 0.0;
+        if (!decoder_->grab(pts)) return false;
+        fullPts_ = pts;
+        fullIndex_ = timeline_.indexAt(pts);
+    }
+
+    out = DecodedFrame();
+    out.index = fullIndex_;
+    out.ptsMs = fullPts_;
+    return retrieveFullFrom(*decoder_, out);
+}
+
+bool VideoSource::retrieveFull(int index, DecodedFrame &out)
+{
+    if (!isOpen()) return false;
+    if (proxyFile_) return retrieveOriginal(index, out);
+
+    const cv::Size proxy = proxySize_;
+    proxySize_ = cv::Size();
+    const bool ok = index == lastIndex_ ? retrieveInto(out) : seekToIndex(index, out);
+    proxySize_ = proxy;
+    return ok;
+}
+
+bool VideoSource::seekToIndex(int index, DecodedFrame &out)
+{
+    index = std::clamp(index, 0, std::max(0, frameCount() - 1));
+    return seekToPts(timeline_.ptsAt(index), out);
+}
+
+int VideoSource::decodeRange(int first, int last, int stride, const std::atomic_bool *cancel,
+                             const std::function<void(DecodedFrame &&)> &sink)
+{
+    if (!isOpen()) return 0;
+    stride = std::max(1, stride);
+
+    int delivered = 0;
+    double pos = nav()->seekAndGrab(navPtsFor(first));
+    while (pos >= 0.0 && !(cancel && cancel->load()))
+    {
+        landedAt(pos);
+        if (lastIndex_ > last) break;
+
+        DecodedFrame f;
+        if ((lastIndex_ - first) % stride == 0 && retrieveInto(f))
+        {
+            sink(std::move(f));
+            ++delivered;
+        }
+
+        // Skipped frames are only grabbed, never converted
+        VDT_TRACE_SCOPE("grab");
+        if (!nav()->grab(pos)) break;
+    }
+    return delivered;
+}
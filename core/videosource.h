@@ -0,0 +1,121 @@
+#ifndef VIDEOSOURCE_H
+#define VIDEOSOURCE_H
+
+#include <QImage>
+#include <QString>
+
+#include <opencv2/opencv.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "decodebackend.h"
+#include "framedecoder.h"
+#include "framepool.h"
+#include "videotimeline.h"
+
+// One decoded frame and where it sits on the timeline. Decoders with native
+// pictures leave bgr empty; it is produced on demand (saving) by ensureBgr().
+// In proxy mode bgr is a display-sized copy and fullSize the real size.
+struct DecodedFrame
+{
+    cv::Mat bgr;
+    std::shared_ptr<const NativePicture> native;
+    cv::Size fullSize;
+    int index = 0;
+    double ptsMs = 0.0;
+
+    bool isEmpty() const { return bgr.empty() && !native; }
+    bool isProxy() const { return !bgr.empty() && !fullSize.empty() && fullSize != bgr.size(); }
+    cv::Size size() const;                      // full-resolution size, also for proxies
+    bool ensureBgr();                           // false for proxies: see VideoSource::retrieveFull()
+    bool toDisplay(const QSize &size, QImage &rgb32) const;    // RGB32 at exactly size
+};
+
+// A video file behind a FrameDecoder (VideoCapture or native libavcodec),
+// addressed by frame index / PTS.
+// With a proxy file attached (a small all-intra copy, one frame per source
+// frame) navigation decodes the proxy and retrieveFull() the original.
+// Not thread-safe: use one instance per thread (bursts open their own).
+class VideoSource
+{
+public:
+    VideoSource() = default;
+    VideoSource(const VideoSource &) = delete;
+    VideoSource &operator=(const VideoSource &) = delete;
+    // Moving hands a prepared source to another thread (see prepareVideo())
+    VideoSource(VideoSource &&) = default;
+    VideoSource &operator=(VideoSource &&) = default;
+
+    // Applies to the next open().
+    void setOptions(const DecodeOptions &opt) { options_ = opt; }
+    const DecodeOptions &options() const { return options_; }
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return decoder_ && decoder_->isOpen(); }
+    QString backendName() const;            // what OpenCV actually picked
+    QString codecName() const { return isOpen() ? decoder_->codecName() : QString(); }
+
+    const QString &path() const { return path_; }
+    double nominalFps() const { return fps_; }
+    cv::Size frameSize() const { return fullSize_; }
+    int frameCount() const { return timeline_.frameCount(); }
+
+    // CFR estimate after open(); replace with the scanned table when ready.
+    const VideoTimeline &timeline() const { return timeline_; }
+    void setTimeline(VideoTimeline t);
+
+    // Index of the frame the next readNext() returns.
+    int nextIndex() const { return lastIndex_ + 1; }
+
+    // Proxy mode: frames come out scaled to fit maxSize (empty = off).
+    void setProxySize(const cv::Size &maxSize) { proxySize_ = maxSize; }
+    const cv::Size &proxySize() const { return proxySize_; }
+    // Full-resolution copy of frame index from the original: re-retrieved if
+    // the decoder still sits on it, otherwise decoded forward or seeked to.
+    bool retrieveFull(int index, DecodedFrame &out);
+
+    // Rejected when its frame count does not match the source; dropped again
+    // if a later setTimeline() disagrees.
+    bool attachProxyFile(const QString &path);
+    void detachProxyFile();
+    bool hasProxyFile() const { return proxyFile_ != nullptr; }
+
+    bool readNext(DecodedFrame &out);       // grab + retrieve
+    bool skipNext();                        // grab only, no pixel conversion
+    bool seekToPts(double ptsMs, DecodedFrame &out);
+    bool seekToIndex(int index, DecodedFrame &out);
+
+    // Decodes [first, last] sequentially from one seek, handing every
+    // stride-th frame to sink; frames in between are only grabbed.
+    // Returns how many frames were delivered. Meant for sources without a
+    // proxy file (it would deliver proxy frames).
+    int decodeRange(int first, int last, int stride, const std::atomic_bool *cancel,
+                    const std::function<void(DecodedFrame &&)> &sink);
+
+private:
+    FrameDecoder *nav() const { return proxyFile_ ? proxyFile_.get() : decoder_.get(); }
+    double navPtsFor(int index) const;
+    void landedAt(double pts);          // navigation decoder now holds the frame at pts
+    bool retrieveInto(DecodedFrame &out);
+    bool retrieveFullFrom(FrameDecoder &dec, DecodedFrame &out);
+    bool retrieveOriginal(int index, DecodedFrame &out);
+
+    std::unique_ptr<FrameDecoder> decoder_;
+    std::unique_ptr<FrameDecoder> proxyFile_;
+    VideoTimeline proxyTimeline_;       // the proxy's own (constant-rate) clock
+    DecodeOptions options_;
+    QString path_;
+    double fps_ = 30.0;
+    VideoTimeline timeline_;
+    cv::Size proxySize_;
+    cv::Size fullSize_;
+    int lastIndex_ = -1;                // navigation decoder position
+    double lastPts_ = 0.0;
+    int fullIndex_ = -1;                // original decoder position
+    double fullPts_ = 0.0;
+};
+
+#endif // VIDEOSOURCE_H
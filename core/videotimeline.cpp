@@ -0,0 +1,148 @@
+#include "videotimeline.h"
+#include "fileutil.h"
+#include "framedecoder.h"
+#include "trace.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+
+#include <opencv2/opencv.hpp>
+
+#include <algorithm>
+
+VideoTimeline VideoTimeline::fromConstantRate(int frameCount, double fps)
+{
+    VideoTimeline t;
+    if (fps <= 0.0) fps = 30.0;
+    t.nominalDurationMs_ = 1000.0 / fps;
+    t.pts_.resize(std::max(0, frameCount));
+    for (size_t i = 0; i < t.pts_.size(); ++i)
+        t.pts_[i] = static_cast<double>(i) * t.nominalDurationMs_;
+    t.exact_ = false;
+    return t;
+}
+
+VideoTimeline VideoTimeline::scan(const QString &path, const std::atomic_bool *cancel,
+                                  const DecodeOptions &opt)
+{
+    VDT_TRACE_SCOPE("timeline scan");
+    VideoTimeline t;
+
+    // Same decoder as playback so both agree on timestamps
+    std::unique_ptr<FrameDecoder> dec = createDecoder(opt);
+    if (!dec->open(path, opt)) return t;
+
+    double fps = dec->nominalFps();
+    if (fps <= 0.0) fps = 30.0;
+    t.nominalDurationMs_ = 1000.0 / fps;
+
+    const int expected = dec->frameCountHint();
+    if (expected > 0) t.pts_.reserve(expected);
+
+    double pts = 0.0;
+    while (dec->grab(pts))
+    {
+        if (cancel && cancel->load()) return VideoTimeline();
+
+        // Some backends report nothing useful; keep the table strictly increasing
+        if (!t.pts_.empty() && pts <= t.pts_.back())
+            pts = t.pts_.back() + t.nominalDurationMs_;
+        t.pts_.push_back(pts);
+    }
+
+    t.exact_ = !t.pts_.empty();
+    return t;
+}
+
+namespace {
+
+constexpr quint32 kTimelineMagic = 0x56445454;  // "VDTT"
+constexpr quint32 kTimelineVersion = 1;
+
+} // namespace
+
+bool VideoTimeline::save(const QString &file) const
+{
+    if (!exact_) return false;      // estimates are not worth keeping
+    QSaveFile f(file);
+    if (!f.open(QIODevice::WriteOnly)) return false;
+    QDataStream out(&f);
+    out << kTimelineMagic << kTimelineVersion << nominalDurationMs_ << quint32(pts_.size());
+    for (double p : pts_) out << p;
+    return out.status() == QDataStream::Ok && f.commit();
+}
+
+VideoTimeline VideoTimeline::load(const QString &file)
+{
+    VideoTimeline t;
+    QFile f(file);
+    if (!f.open(QIODevice::ReadOnly)) return t;
+    QDataStream in(&f);
+    quint32 magic = 0, version = 0, count = 0;
+    in >> magic >> version >> t.nominalDurationMs_ >> count;
+    if (magic != kTimelineMagic || version != kTimelineVersion) return VideoTimeline();
+    // Guard the allocation against a corrupt count
+    if (qint64(count) * qint64(sizeof(double)) > f.size()) return VideoTimeline();
+
+    t.pts_.resize(count);
+    for (double &p : t.pts_) in >> p;
+    if (in.status() != QDataStream::Ok || t.pts_.empty()) return VideoTimeline();
+    t.exact_ = true;
+    return t;
+}
+
+QString timelineCachePathFor(const QString &source, const QString &cacheDir)
+{
+    return QDir(cacheDir).filePath(sourceCacheKey(source) + ".pts");
+}
+
+double VideoTimeline::ptsAt(int index) const
+{
+    if (pts_.empty()) return 0.0;
+    index = std::clamp(index, 0, frameCount() - 1);
+    return pts_[index];
+}
+
+double VideoTimeline::frameDurationAt(int index) const
+{
+    if (index < 0 || index + 1 >= frameCount()) return nominalDurationMs_;
+    return pts_[index + 1] - pts_[index];
+}
+
+double VideoTimeline::durationMs() const
+{
+    if (pts_.empty()) return 0.0;
+    return pts_.back() + nominalDurationMs_;
+}
+
+double grabAtPts(cv::VideoCapture &cap, double targetMs)
+{
+    VDT_TRACE_SCOPE("seek");
+    double preroll = 0.0;
+    double pos = -1.0;
+    for (int attempt = 0; attempt < 4; ++attempt)
+    {
+        cap.set(cv::CAP_PROP_POS_MSEC, std::max(0.0, targetMs - preroll));
+        if (!cap.grab()) return -1.0;
+        pos = cap.get(cv::CAP_PROP_POS_MSEC);
+        if (pos <= targetMs + 0.5) break;
+        preroll = (preroll <= 0.0) ? 500.0 : preroll * 2.0;   // overshot, back off
+    }
+    while (pos < targetMs - 0.5)
+    {
+        if (!cap.grab()) return -1.0;
+        pos = cap.get(cv::CAP_PROP_POS_MSEC);
+    }
+    return pos;
+}
+
+int VideoTimeline::indexAt(double ptsMs) const
+{
+    if (pts_.empty()) return 0;
+    // Last frame whose PTS is <= ptsMs (small tolerance for float round-trips)
+    auto it = std::upper_bound(pts_.begin(), pts_.end(), ptsMs + 0.5);
+    if (it == pts_.begin()) return 0;
+    return static_cast<int>(std::distance(pts_.begin(), it)) - 1;
+}
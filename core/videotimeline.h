@@ -0,0 +1,58 @@
+#ifndef VIDEOTIMELINE_H
+#define VIDEOTIMELINE_H
+
+#include <QString>
+
+#include <atomic>
+#include <vector>
+
+#include "decodebackend.h"
+
+namespace cv { class VideoCapture; }
+
+// Presentation timestamps (ms) of every frame of a video.
+// Navigation works in media time and derives the frame index from this table,
+// so variable-frame-rate recordings (phones) play and seek correctly.
+class VideoTimeline
+{
+public:
+    VideoTimeline() = default;
+
+    // Placeholder until the real table is known: assumes constant frame rate.
+    static VideoTimeline fromConstantRate(int frameCount, double fps);
+
+    // Walks the whole file with grab() only (no pixel conversion) and records
+    // the PTS of every frame. Returns an empty timeline on failure / cancel.
+    static VideoTimeline scan(const QString &path, const std::atomic_bool *cancel = nullptr,
+                              const DecodeOptions &opt = DecodeOptions());
+
+    // Scanned tables are cached on disk (see sourceCacheKey()) so reopening a
+    // file skips the scan. load() returns an empty timeline if unreadable.
+    bool save(const QString &file) const;
+    static VideoTimeline load(const QString &file);
+
+    bool isEmpty() const { return pts_.empty(); }
+    bool isExact() const { return exact_; }
+    int frameCount() const { return static_cast<int>(pts_.size()); }
+
+    double ptsAt(int index) const;              // clamped to the valid range
+    double frameDurationAt(int index) const;    // until the next frame
+    double durationMs() const;                  // end of the last frame
+    int indexAt(double ptsMs) const;            // frame on screen at that time
+
+private:
+    std::vector<double> pts_;
+    double nominalDurationMs_ = 1000.0 / 30.0;
+    bool exact_ = false;
+};
+
+// Cache file for source's scanned table under cacheDir.
+QString timelineCachePathFor(const QString &source, const QString &cacheDir);
+
+// Positions cap on the frame with PTS targetMs (grabbed, ready to retrieve()).
+// OpenCV turns POS_MSEC into a frame number with the nominal FPS, which is off
+// for VFR files, so this lands early and grabs forward. Returns the landed PTS,
+// or a negative value at end of stream.
+double grabAtPts(cv::VideoCapture &cap, double targetMs);
+
+#endif // VIDEOTIMELINE_H
@@ -7,6 +7,14 @@
 #include <QMessageBox>
 #include <QKeyEvent>
 #include <QTextStream>
+#include <QTime>
+#include <QInputDialog>
+#include <QMenuBar>
+#include <QActionGroup>
+#include <QPainter>
+#include <QCryptographicHash>
+
+#include <QtConcurrent/QtConcurrentRun>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -14,6 +22,7 @@ MainWindow::MainWindow(QWidget *parent)
 {
     ui->setupUi(this);
     ui->playPauseBtn->setFocus();
+    VDT_TRACE_THREAD("GUI");
 
     ui->nextImageLabel->setStyleSheet(
         "QLabel {"
@@ -65,7 +74,7 @@ MainWindow::MainWindow(QWidget *parent)
     // Let the video area expand with the window
     ui->videoLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     ui->videoLabel->setMinimumSize(1, 1);
-    ui->videoLabel->setScaledContents(false); // we scale manually in displayMat()
+    ui->videoLabel->setScaledContents(false); // we scale manually in displayFrame()
 
     // kill extra margins around the video
     if (ui->videoGroupLayout) ui->videoGroupLayout->setContentsMargins(0,0,0,0);
@@ -74,17 +83,74 @@ MainWindow::MainWindow(QWidget *parent)
     // Install event filter if you later want to catch more keys
     this->installEventFilter(this);
 
+    // Ctrl+drag on the video selects the region saved frames are cropped to
+    roiBand_ = new QRubberBand(QRubberBand::Rectangle, ui->videoLabel);
+    setupCaptureMenu();
+    setupAnnotateMenu();
+    setupPlaylistMenu();
+
+    // Performance HUD, top-left over the video; refreshed a few times a second
+    hudLabel_ = new QLabel(ui->videoLabel);
+    hudLabel_->setAttribute(Qt::WA_TransparentForMouseEvents);
+    hudLabel_->setStyleSheet(
+        "QLabel {"
+        "  color: #e8f2ff;"
+        "  background: rgba(20, 30, 50, 170);"
+        "  border-radius: 6px;"
+        "  padding: 4px 8px;"
+        "  font: 9pt 'Consolas', 'DejaVu Sans Mono', monospace;"
+        "}"
+        );
+    hudLabel_->move(8, 8);
+    hudLabel_->hide();
+    hudStatus_ = new QLabel(this);
+    statusBar()->addPermanentWidget(hudStatus_);
+    hudStatus_->hide();
+    connect(&hudTimer_, &QTimer::timeout, this, &MainWindow::refreshHud);
+    setupViewMenu();
+    setupDecodeMenu();
+
     // Where we keep our tiny "database"
     const QString appData = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir().mkpath(appData);
-    configPath_ = appData + QDir::separator() + "config.txt";
+    config_.setPath(appData + QDir::separator() + "config.txt");
+    progress_.open(appData + QDir::separator() + "progress.jsonl");
+    sink_.setStats(&perf_);
 
     loadConfig();
-    recalcNextImageFromDir();
+    grayscaleAction_->setChecked(output_.grayscale);
+    contentNamesAction_->setChecked(contentNames_);
+    shardAction_->setChecked(index_.shardSize() > 0);
+    yoloAction_->setChecked(annotationFormats_ & AnnotationYolo);
+    cocoAction_->setChecked(annotationFormats_ & AnnotationCoco);
+    saveSuggestionsAction_->setChecked(saveSuggestions_);
+    hwAccelAction_->setChecked(decode_.hwAccel);
+    proxyAction_->setChecked(proxyPlayback_);
+    proxyFilesAction_->setChecked(proxyFiles_);
+    updateProxySize();
+    rebuildBackendMenu();
+    setHudVisible(hudEnabled_);
     updateInfoLabels();
 
-    // Connect timer for playback
+    // Detector results come from the prelabel thread
+    prelabeler_.setDone([this](const QString &videoPath, int frame, const std::vector<Annotation> &boxes) {
+        QMetaObject::invokeMethod(this, [this, videoPath, frame, boxes]() {
+            onSuggestions(videoPath, frame, boxes);
+        }, Qt::QueuedConnection);
+    });
+    if (!prelabelModel_.isEmpty()) setPrelabelModel(prelabelModel_);
+
+    // Connect timer for playback (re-armed per frame from the PTS table)
+    timer_.setSingleShot(true);
     connect(&timer_, &QTimer::timeout, this, &MainWindow::tick);
+    connect(&timelineWatcher_, &QFutureWatcher<VideoTimeline>::finished, this, &MainWindow::onTimelineScanned);
+    connect(&probeWatcher_, &QFutureWatcher<std::vector<BackendProbe>>::finished, this, &MainWindow::onBackendsProbed);
+    fullResTimer_.setSingleShot(true);
+    connect(&fullResTimer_, &QTimer::timeout, this, &MainWindow::onFullResTimeout);
+    positionTimer_.setSingleShot(true);
+    positionTimer_.setInterval(kPositionDelayMs);
+    connect(&positionTimer_, &QTimer::timeout, this, &MainWindow::recordPosition);
+    connect(&proxyBuildWatcher_, &QFutureWatcher<bool>::finished, this, &MainWindow::onProxyFileBuilt);
 
     // Keyboard shortcut: press 'S' to save current frame
     saveShortcut_ = new QShortcut(QKeySequence(Qt::Key_S), this);
@@ -97,8 +163,8 @@ MainWindow::MainWindow(QWidget *parent)
     // Reflect paths in labels if available
     if (!lastVideoPath_.isEmpty())
         ui->videoPathLabel->setText(lastVideoPath_);
-    if (!saveDirPath_.isEmpty())
-        ui->saveDirLabel->setText(saveDirPath_);
+    if (index_.hasDirectory())
+        ui->saveDirLabel->setText(index_.directory());
 
     // If last video exists, open it (but don't auto-play)
     if (!lastVideoPath_.isEmpty() && QFile::exists(lastVideoPath_))
@@ -107,7 +173,21 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    prelabeler_.clear();
+    if (timelineCancel_) timelineCancel_->store(true);
+    if (probeCancel_) probeCancel_->store(true);
+    if (prefetchCancel_) prefetchCancel_->store(true);
+    if (proxyBuildCancel_) proxyBuildCancel_->store(true);
+    if (burstCancel_) burstCancel_->store(true);
+    if (trackCancel_) trackCancel_->store(true);
+    burstFuture_.waitForFinished();
+    trackFuture_.waitForFinished();
+    proxyBuildWatcher_.waitForFinished();
+    prefetchWatcher_.waitForFinished();
+    sink_.waitForDone();
+    recordPosition();
     saveConfig();
+    config_.flush();
     delete ui;
 }
 
@@ -117,38 +197,35 @@ void MainWindow::on_selectVideoBtn_clicked()
 {
     QString path = QFileDialog::getOpenFileName(this, "Select Video",
                                                 lastVideoPath_.isEmpty() ? QDir::homePath() : QFileInfo(lastVideoPath_).absolutePath(),
-                                                "Videos (*.mp4 *.avi *.mkv *.mov *.m4v *.webm);;All Files (*)");
+                                                QString("Videos (%1);;All Files (*)").arg(Playlist::nameFilters().join(' ')));
     if (path.isEmpty()) return;
 
     openVideo(path);
-    lastVideoPath_ = path;
-    ui->videoPathLabel->setText(path);
     saveConfig();
 }
 
 void MainWindow::on_selectDirBtn_clicked()
 {
     QString dir = QFileDialog::getExistingDirectory(this, "Select Save Directory",
-                                                    saveDirPath_.isEmpty() ? QDir::homePath() : saveDirPath_);
+                                                    index_.hasDirectory() ? index_.directory() : QDir::homePath());
     if (dir.isEmpty()) return;
 
-    saveDirPath_ = dir;
+    setSaveDirectory(dir);
     ui->saveDirLabel->setText(dir);
 
-    recalcNextImageFromDir();
     updateInfoLabels();
     saveConfig();
 }
 
 void MainWindow::on_playPauseBtn_clicked()
 {
-    if (!cap_.isOpened()) return;
+    if (!source_.isOpen()) return;
     setPlaying(!playing_);
 }
 
 void MainWindow::on_reloadVideoBtn_clicked()
 {
-    if (!cap_.isOpened()) return;
+    if (!source_.isOpen()) return;
     // Restart from the beginning and start playing
     setPlaying(false);
     seekTo(0);
@@ -157,22 +234,22 @@ void MainWindow::on_reloadVideoBtn_clicked()
 
 void MainWindow::on_preVideoBtn_clicked()
 {
-    if (!cap_.isOpened()) return;
+    if (!source_.isOpen()) return;
     setPlaying(false);
     stepRelative(-1);
 }
 
 void MainWindow::on_nextVideoBtn_clicked()
 {
-    if (!cap_.isOpened()) return;
+    if (!source_.isOpen()) return;
     setPlaying(false);
     stepRelative(+1);
 }
 
 void MainWindow::on_timeSlider_sliderMoved(int value)
 {
-    if (!cap_.isOpened()) return;
-    seekTo(value);
+    if (!source_.isOpen()) return;
+    seekToPts(value);   // slider is in milliseconds
 }
 
 void MainWindow::on_timeSlider_sliderPressed()
@@ -183,10 +260,10 @@ void MainWindow::on_timeSlider_sliderPressed()
 
 void MainWindow::on_timeSlider_sliderReleased()
 {
-    if (!cap_.isOpened()) { sliderHeld_ = false; return; }
+    if (!source_.isOpen()) { sliderHeld_ = false; return; }
     // Finalize position at the released value (cheap, but ensures sync)
     int target = ui->timeSlider->value();
-    seekTo(target);
+    seekToPts(target);
     sliderHeld_ = false;
 }
 
@@ -194,23 +271,38 @@ void MainWindow::on_timeSlider_sliderReleased()
 
 void MainWindow::tick()
 {
-    if (!cap_.isOpened()) return;
+    if (!source_.isOpen()) return;
+
+    // Running late: frames whose display slot already passed are skipped, not shown
+    const VideoTimeline &timeline = source_.timeline();
+    int target = currentFrameIndex_ + 1;
+    if (playing_)
+    {
+        const double now = playStartPtsMs_ + static_cast<double>(playClock_.elapsed());
+        while (target + 1 < timeline.frameCount() && timeline.ptsAt(target + 1) <= now)
+            ++target;
+    }
 
-    cv::Mat frame;
-    if (!cap_.read(frame))
+    DecodedFrame frame;
+    bool ok = false;
+    {
+        PerfScope t(perf_, PerfStats::Decode);
+        ok = cache_.fetch(source_, target, frame);
+    }
+    if (!ok)
     {
         // End of video => stop
         setPlaying(false);
         return;
     }
+    for (int i = currentFrameIndex_ + 1; i < frame.index; ++i)
+        perf_.frameDropped();
 
-    currentFrameIndex_ = static_cast<int>(cap_.get(cv::CAP_PROP_POS_FRAMES)) - 1;
-    currentFrameBGR_ = frame.clone();
+    showFrame(frame);
+    perf_.frameShown();
 
-    displayMat(currentFrameBGR_);
-    if (!sliderHeld_)
-        ui->timeSlider->setValue(currentFrameIndex_);
-    updateInfoLabels();
+    if (playing_)
+        scheduleNextTick();
 }
 
 // ================== Helpers ==================
@@ -265,81 +357,188 @@ void MainWindow::showOverlayGlyph(const QString &glyph)
 
 void MainWindow::togglePlayPause()
 {
-    if (!cap_.isOpened()) return;   // no video loaded → ignore
+    if (!source_.isOpen()) return;   // no video loaded → ignore
     setPlaying(!playing_);
 }
 
 void MainWindow::openVideo(const QString &path)
 {
-    if (cap_.isOpened()) cap_.release();
-
-    cap_.open(path.toStdString());
-    if (!cap_.isOpened())
+    if (timelineCancel_) timelineCancel_->store(true);
+    stopTracking();
+    prelabeler_.clear();
+    suggestions_.clear();
+    recordPosition();
+    cache_.clear();
+
+    // The prefetched neighbour is already open with frame 0 decoded
+    std::shared_ptr<PreparedVideo> prepared = takePrefetched(path);
+    if (prepared)
+        source_ = std::move(prepared->source);
+    else if (!openSource(path))
     {
         QMessageBox::warning(this, "Error", "Failed to open video.");
         return;
     }
+    lastVideoPath_ = path;
+    ui->videoPathLabel->setText(path);
+    updateProxySize();
+    loadAnnotations();
 
-    fps_ = cap_.get(cv::CAP_PROP_FPS);
-    if (fps_ <= 0.0) fps_ = 30.0;
+    // PTS table from an earlier visit, else it is built in the background
+    if (!source_.timeline().isExact())
+    {
+        VideoTimeline cached = VideoTimeline::load(timelineCachePathFor(path, cacheDir("timelines")));
+        if (!cached.isEmpty()) source_.setTimeline(std::move(cached));
+    }
 
-    frameCount_ = static_cast<int>(cap_.get(cv::CAP_PROP_FRAME_COUNT));
     currentFrameIndex_ = 0;
-
+    currentPtsMs_ = 0.0;
     ensureSliderRange();
-    updateTimerFromFPS();
 
-    // Show first frame
-    seekTo(0);
+    // Show first frame, or resume where review of this video stopped
+    if (prepared) cache_.put(prepared->first);
+    const VideoProgress progress = progress_.get(path);
+    seekTo(progress.lastFrame);
     // setPlaying(false);
+
+    if (!source_.timeline().isExact())
+        startTimelineScan(path);
+    if (decodeAuto_)
+        autoSelectBackend();
+    startProxyFile();
+
+    syncPlaylist(path);
+    startPrefetch();
+    reviewedAction_->setChecked(progress.done);
+    showPlaylistStatus();
+}
+
+bool MainWindow::openSource(const QString &path)
+{
+    DecodeOptions opt = effectiveDecodeOptions();
+    source_.setOptions(opt);
+    if (source_.open(path)) return true;
+
+    // A backend that won on another file may not handle this one
+    if (opt.api == cv::CAP_ANY) return false;
+    opt.api = cv::CAP_ANY;
+    source_.setOptions(opt);
+    return source_.open(path);
 }
 
-void MainWindow::updateTimerFromFPS()
+void MainWindow::startTimelineScan(const QString &path)
 {
-    int intervalMs = static_cast<int>(1000.0 / std::max(1.0, fps_));
-    timer_.setInterval(intervalMs);
+    auto cancel = std::make_shared<std::atomic_bool>(false);
+    timelineCancel_ = cancel;
+    const DecodeOptions opt = source_.options();
+    timelineWatcher_.setFuture(QtConcurrent::run([path, cancel, opt]() {
+        return VideoTimeline::scan(path, cancel.get(), opt);
+    }));
+}
+
+void MainWindow::onTimelineScanned()
+{
+    VideoTimeline t = timelineWatcher_.result();
+    if (t.isEmpty() || !source_.isOpen()) return;   // cancelled or unreadable
+
+    t.save(timelineCachePathFor(source_.path(), cacheDir("timelines")));
+
+    // Cached frames were indexed against the estimate
+    source_.setTimeline(std::move(t));
+    cache_.clear();
+    currentFrameIndex_ = source_.timeline().indexAt(currentPtsMs_);
+
+    ensureSliderRange();
+    if (!sliderHeld_)
+        ui->timeSlider->setValue(static_cast<int>(currentPtsMs_));
+    updateInfoLabels();
+}
+
+void MainWindow::scheduleNextTick()
+{
+    // Next frame is due when the media clock reaches its PTS
+    const double nextPts = currentPtsMs_ + source_.timeline().frameDurationAt(currentFrameIndex_);
+    const double dueMs = (nextPts - playStartPtsMs_) - static_cast<double>(playClock_.elapsed());
+    timer_.start(std::max(0, static_cast<int>(dueMs)));
 }
 
 void MainWindow::ensureSliderRange()
 {
+    const VideoTimeline &timeline = source_.timeline();
+    const int lastPts = static_cast<int>(timeline.ptsAt(timeline.frameCount() - 1));
     ui->timeSlider->setMinimum(0);
-    ui->timeSlider->setMaximum(std::max(0, frameCount_ - 1));
-    ui->timeSlider->setSingleStep(1);
-    ui->timeSlider->setPageStep(std::max(1, frameCount_ / 20));
+    ui->timeSlider->setMaximum(std::max(0, lastPts));
+    ui->timeSlider->setSingleStep(std::max(1, static_cast<int>(timeline.frameDurationAt(0))));
+    ui->timeSlider->setPageStep(std::max(1, static_cast<int>(timeline.durationMs() / 20)));
 }
 
 void MainWindow::seekTo(int frameIndex)
 {
-    if (!cap_.isOpened()) return;
+    if (!source_.isOpen()) return;
 
-    frameIndex = std::clamp(frameIndex, 0, std::max(0, frameCount_ - 1));
-    cap_.set(cv::CAP_PROP_POS_FRAMES, frameIndex);
+    frameIndex = std::clamp(frameIndex, 0, std::max(0, source_.frameCount() - 1));
 
-    cv::Mat frame;
-    if (cap_.read(frame))
+    // Cache hit or a short hop forward avoids the keyframe seek entirely
+    DecodedFrame frame;
+    if (cache_.fetch(source_, frameIndex, frame))
     {
-        currentFrameIndex_ = static_cast<int>(cap_.get(cv::CAP_PROP_POS_FRAMES)) - 1;
-        currentFrameBGR_ = frame.clone();
-        displayMat(currentFrameBGR_);
+        showFrame(frame);
 
-        // IMPORTANT: don't fight the user while scrubbing
-        if (!sliderHeld_)
-            ui->timeSlider->setValue(currentFrameIndex_);
+        // Re-anchor the playback clock at the new position
+        if (playing_)
+        {
+            playStartPtsMs_ = currentPtsMs_;
+            playClock_.restart();
+            scheduleNextTick();
+        }
     }
     updateInfoLabels();
+    positionTimer_.start();     // restarts: scrubbing records once, where it ends
+}
+
+void MainWindow::seekToPts(double ptsMs)
+{
+    if (!source_.isOpen()) return;
+    seekTo(source_.timeline().indexAt(ptsMs));
+}
+
+void MainWindow::showFrame(const DecodedFrame &f)
+{
+    currentPtsMs_ = f.ptsMs;
+    currentFrameIndex_ = f.index;
+    currentFrame_ = f;             // decoder hands out fresh buffers; no clone needed
+    displayFrame(currentFrame_);
+    if (currentFrame_.isProxy() && !playing_)
+        fullResTimer_.start(kFullResDelayMs);
+
+    // IMPORTANT: don't fight the user while scrubbing
+    if (!sliderHeld_)
+        ui->timeSlider->setValue(static_cast<int>(currentPtsMs_));
+    updateInfoLabels();
 }
 
 void MainWindow::stepRelative(int deltaFrames)
 {
-    int target = currentFrameIndex_ + deltaFrames;
-    seekTo(target);
+    // +1 is a plain sequential read; the cache makes short steps back cheap
+    seekTo(currentFrameIndex_ + deltaFrames);
 }
 
 void MainWindow::setPlaying(bool on)
 {
     playing_ = on;
-    if (playing_) timer_.start();
-    else          timer_.stop();
+    if (playing_)
+    {
+        playStartPtsMs_ = currentPtsMs_;
+        playClock_.start();
+        scheduleNextTick();
+    }
+    else
+    {
+        timer_.stop();
+        if (currentFrame_.isProxy())
+            fullResTimer_.start(kFullResDelayMs);
+        positionTimer_.start();
+    }
 
     ui->playPauseBtn->setToolTip(playing_ ? "Pause" : "Play");
 
@@ -347,153 +546,1489 @@ void MainWindow::setPlaying(bool on)
     showOverlayGlyph(playing_ ? "▶" : "⏸");
 }
 
-void MainWindow::displayMat(const cv::Mat &bgr)
+void MainWindow::displayFrame(const DecodedFrame &f)
 {
-    if (bgr.empty()) return;
-    QImage img = matToQImage(bgr);
-    // Keep aspect fit inside the QLabel
-    QPixmap pix = QPixmap::fromImage(img).scaled(ui->videoLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    if (f.isEmpty()) return;
+
+    // Keep aspect fit inside the QLabel; scale first, then convert once at that size
+    const cv::Size full = f.size();
+    const QSize size = fitInside(QSize(full.width, full.height), ui->videoLabel->size());
+    if (size.isEmpty()) return;
+
+    {
+        PerfScope t(perf_, PerfStats::ToDisplay);
+        if (!f.toDisplay(size, displayImage_)) return;
+    }
+    {
+        PerfScope t(perf_, PerfStats::Upload);
+        VDT_TRACE_SCOPE("fromImage");
+        framePixmap_ = QPixmap::fromImage(displayImage_);
+    }
+    requestSuggestions(f.index, full);
+    refreshOverlay();
+}
+
+void MainWindow::refreshOverlay()
+{
+    if (framePixmap_.isNull() || currentFrame_.isEmpty()) return;
+    const cv::Size full = currentFrame_.size();
+    const std::vector<Annotation> shown = annotations_.at(currentFrameIndex_);
+    const std::vector<Annotation> suggested = suggestions_.value(currentFrameIndex_);
+    if (output_.roi.empty() && shown.empty() && suggested.empty())
+    {
+        VDT_TRACE_SCOPE("setPixmap");
+        ui->videoLabel->setPixmap(framePixmap_);
+        return;
+    }
+
+    // Overlays are drawn on a display-size copy (cheap); the frame itself is
+    // never converted again for them
+    QPixmap pix = framePixmap_;
+    const double sx = static_cast<double>(pix.width())  / full.width;
+    const double sy = static_cast<double>(pix.height()) / full.height;
+    QPainter p(&pix);
+
+    // Outline the save ROI
+    if (!output_.roi.empty())
+    {
+        p.setPen(QPen(QColor(255, 200, 0), 2, Qt::DashLine));
+        p.drawRect(QRectF(output_.roi.x * sx, output_.roi.y * sy, output_.roi.width * sx, output_.roi.height * sy));
+    }
+
+    // Detector suggestions dotted grey, under the real annotations
+    p.setPen(QPen(QColor(210, 210, 210), 1, Qt::DotLine));
+    for (const Annotation &a : suggested)
+    {
+        const QRectF r(a.box.x * sx, a.box.y * sy, a.box.width * sx, a.box.height * sy);
+        p.drawRect(r);
+        p.drawText(r.topLeft() + QPointF(3, 12), a.label);
+    }
+
+    // Keyframes solid, interpolated boxes dashed, selection thicker
+    for (const Annotation &a : shown)
+    {
+        const QColor color = QColor::fromHsv((std::max(0, labels_.indexOf(a.label)) * 67) % 360, 200, 255);
+        const bool selected = a.track == selectedTrack_;
+        p.setPen(QPen(color, selected ? 3 : 2, a.keyframe ? Qt::SolidLine : Qt::DashLine));
+        const QRectF r(a.box.x * sx, a.box.y * sy, a.box.width * sx, a.box.height * sy);
+        if (a.isPoint())
+            p.drawEllipse(r.topLeft(), 4, 4);
+        else
+            p.drawRect(r);
+        p.drawText(r.topLeft() + QPointF(3, -3), a.label);
+    }
+    p.end();
+
+    VDT_TRACE_SCOPE("setPixmap");
     ui->videoLabel->setPixmap(pix);
 }
 
-QImage MainWindow::matToQImage(const cv::Mat &bgr)
+QRect MainWindow::displayedFrameRect() const
+{
+    const QPixmap pix = ui->videoLabel->pixmap();
+    if (pix.isNull()) return QRect();
+    // videoLabel centers the pixmap
+    const QSize area = ui->videoLabel->contentsRect().size();
+    return QRect(QPoint((area.width()  - pix.width())  / 2,
+                        (area.height() - pix.height()) / 2) + ui->videoLabel->contentsRect().topLeft(),
+                 pix.size());
+}
+
+void MainWindow::setupCaptureMenu()
 {
-    cv::Mat rgb;
-    if (bgr.channels() == 3)
-        cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
-    else if (bgr.channels() == 4)
-        cv::cvtColor(bgr, rgb, cv::COLOR_BGRA2RGBA);
+    QMenu *capture = ui->menubar->addMenu("&Capture");
+
+    capture->addAction("Output size...", this, &MainWindow::promptOutputSize);
+    capture->addAction("Clear ROI", this, &MainWindow::clearRoi);
+    capture->addAction("Extra resolutions...", this, &MainWindow::promptPyramidWidths);
+    capture->addSeparator();
+    capture->addAction("Burst save (B)", this, &MainWindow::startBurst);
+    capture->addAction("Burst settings...", this, &MainWindow::promptBurstSettings);
+    capture->addSeparator();
+
+    grayscaleAction_ = capture->addAction("Grayscale output");
+    grayscaleAction_->setCheckable(true);
+    connect(grayscaleAction_, &QAction::toggled, this, [this](bool on) {
+        output_.grayscale = on;
+        saveConfig();
+    });
+    contentNamesAction_ = capture->addAction("Name files by content hash");
+    contentNamesAction_->setCheckable(true);
+    connect(contentNamesAction_, &QAction::toggled, this, [this](bool on) {
+        contentNames_ = on;
+        updateInfoLabels();
+        saveConfig();
+    });
+    shardAction_ = capture->addAction(QString("Folders of %1 images").arg(DatasetIndex::kDefaultShardSize));
+    shardAction_->setCheckable(true);
+    connect(shardAction_, &QAction::toggled, this, [this](bool on) {
+        index_.setShardSize(on ? DatasetIndex::kDefaultShardSize : 0);
+        saveConfig();
+    });
+}
+
+void MainWindow::setupViewMenu()
+{
+    QMenu *view = ui->menubar->addMenu("&View");
+
+    hudAction_ = view->addAction("Performance HUD (H)");
+    hudAction_->setCheckable(true);
+    connect(hudAction_, &QAction::toggled, this, &MainWindow::setHudVisible);
+    view->addAction("Reset HUD statistics", this, [this]() { perf_.reset(); refreshHud(); });
+
+#if defined(VDT_ENABLE_TRACING) && VDT_ENABLE_TRACING
+    view->addSeparator();
+    QAction *traceStart = view->addAction("Start trace recording");
+    QAction *traceStop = view->addAction("Stop trace and save...");
+    traceStop->setEnabled(false);
+    connect(traceStart, &QAction::triggered, this, [this, traceStart, traceStop]() {
+        Tracer::instance().start();
+        traceStart->setEnabled(false);
+        traceStop->setEnabled(true);
+        statusBar()->showMessage("Recording trace...", 2000);
+    });
+    connect(traceStop, &QAction::triggered, this, [this, traceStart, traceStop]() {
+        const QString path = QFileDialog::getSaveFileName(this, "Save trace",
+                                                          QDir::home().filePath("vdt_trace.json"),
+                                                          "Chrome trace (*.json)");
+        // Stop even on cancel so the buffer does not keep growing
+        const bool ok = Tracer::instance().stopAndWrite(path.isEmpty() ? QString() : path);
+        traceStart->setEnabled(true);
+        traceStop->setEnabled(false);
+        if (!path.isEmpty())
+            statusBar()->showMessage(ok ? QString("Trace saved: %1").arg(path) : QString("Could not write trace"), 3000);
+    });
+#endif
+}
+
+void MainWindow::setHudVisible(bool on)
+{
+    if (hudAction_->isChecked() != on)
+    {
+        hudAction_->setChecked(on);   // re-enters through toggled()
+        return;
+    }
+    hudEnabled_ = on;
+    hudLabel_->setVisible(on);
+    hudStatus_->setVisible(on);
+    if (on)
+    {
+        refreshHud();
+        hudTimer_.start(250);
+    }
+    else
+    {
+        hudTimer_.stop();
+    }
+}
+
+void MainWindow::refreshHud()
+{
+    QStringList lines;
+    lines << QString("%1 fps   %2 dropped")
+                 .arg(perf_.effectiveFps(), 0, 'f', 1)
+                 .arg(perf_.droppedFrames());
+    lines << QString("%1 %2 %3 %4").arg("stage ms", -9).arg("p50", 6).arg("p95", 6).arg("p99", 6);
+    for (int s = 0; s < PerfStats::StageCount; ++s)
+    {
+        const auto stage = static_cast<PerfStats::Stage>(s);
+        const PerfStats::Summary sum = perf_.summary(stage);
+        if (sum.samples == 0)
+        {
+            lines << QString("%1 %2").arg(PerfStats::stageName(stage), -9).arg("-", 6);
+            continue;
+        }
+        lines << QString("%1 %2 %3 %4")
+                     .arg(PerfStats::stageName(stage), -9)
+                     .arg(sum.p50, 6, 'f', 1)
+                     .arg(sum.p95, 6, 'f', 1)
+                     .arg(sum.p99, 6, 'f', 1);
+    }
+    const FramePool::Stats pool = FramePool::instance().stats();
+    const uint64_t requests = pool.reused + pool.allocated;
+    lines << QString("pool %1 idle (%2 MB), %3% reused")
+                 .arg(pool.freeBuffers)
+                 .arg(pool.freeBytes / (1024.0 * 1024.0), 0, 'f', 0)
+                 .arg(requests ? 100.0 * pool.reused / requests : 0.0, 0, 'f', 0);
+    hudLabel_->setText(lines.join('\n'));
+    hudLabel_->adjustSize();
+
+    const PerfStats::Summary decode = perf_.summary(PerfStats::Decode);
+    hudStatus_->setText(QString("%1 fps • %2 dropped • decode p50 %3 ms • %4")
+                            .arg(perf_.effectiveFps(), 0, 'f', 1)
+                            .arg(perf_.droppedFrames())
+                            .arg(decode.p50, 0, 'f', 1)
+                            .arg(source_.isOpen() ? source_.backendName() : QString("-")));
+}
+
+void MainWindow::promptOutputSize()
+{
+    const QString current = (output_.size.width > 0 || output_.size.height > 0)
+        ? QString("%1x%2").arg(output_.size.width).arg(output_.size.height)
+        : QString();
+
+    bool ok = false;
+    const QString text = QInputDialog::getText(this, "Output size",
+                                               "Saved frame size as WxH (0 keeps aspect, e.g. 640x0).\n"
+                                               "Leave empty to keep the original size.",
+                                               QLineEdit::Normal, current, &ok).trimmed();
+    if (!ok) return;
+
+    const QStringList p = text.split('x');
+    if (text.isEmpty())
+        output_.size = cv::Size();
+    else if (p.size() == 2)
+        output_.size = cv::Size(std::max(0, p[0].toInt()), std::max(0, p[1].toInt()));
     else
-        cv::cvtColor(bgr, rgb, cv::COLOR_GRAY2RGB);
+        output_.size = cv::Size(std::max(0, text.toInt()), 0);   // plain width
+    saveConfig();
+}
 
-    return QImage(rgb.data, rgb.cols, rgb.rows, static_cast<int>(rgb.step), QImage::Format_RGB888).copy();
+void MainWindow::promptPyramidWidths()
+{
+    QStringList current;
+    for (int w : output_.pyramidWidths) current << QString::number(w);
+
+    bool ok = false;
+    const QString text = QInputDialog::getText(this, "Extra resolutions",
+                                               "Widths of additional smaller copies, comma separated (e.g. 320,160).\n"
+                                               "Each is saved into a \"<width>px\" subfolder. Leave empty for none.",
+                                               QLineEdit::Normal, current.join(','), &ok).trimmed();
+    if (!ok) return;
+
+    output_.pyramidWidths.clear();
+    for (const QString &part : text.split(',', Qt::SkipEmptyParts))
+    {
+        const int w = part.trimmed().toInt();
+        if (w > 0) output_.pyramidWidths.push_back(w);
+    }
+    saveConfig();
+}
+
+void MainWindow::clearRoi()
+{
+    output_.roi = cv::Rect();
+    refreshOverlay();
+    saveConfig();
 }
 
 void MainWindow::updateInfoLabels()
 {
-    ui->frameInfoLabel->setText(QString("Frame: %1 / %2").arg(currentFrameIndex_).arg(frameCount_));
-    ui->nextImageLabel->setText(QString("Next image: %1").arg(nextImageIndex_));
+    const QString ts = QTime::fromMSecsSinceStartOfDay(static_cast<int>(currentPtsMs_)).toString("mm:ss.zzz");
+    ui->frameInfoLabel->setText(QString("Frame: %1 / %2 (%3)").arg(currentFrameIndex_).arg(source_.frameCount()).arg(ts));
+    ui->nextImageLabel->setText(contentNames_ ? QString("Next image: by content hash")
+                                              : QString("Next image: %1").arg(index_.nextIndex()));
 }
 
 void MainWindow::saveCurrentFrame()
 {
-    if (currentFrameBGR_.empty())
+    if (currentFrame_.isEmpty())
         return;
 
-    if (saveDirPath_.isEmpty())
+    if (!index_.hasDirectory())
     {
         QMessageBox::information(this, "Save directory required", "Please select a save directory first.");
         return;
     }
+    if (!index_.isWritable())
+    {
+        QMessageBox::warning(this, "Save failed", "The save directory is not writable.");
+        return;
+    }
 
-    QDir dir(saveDirPath_);
+    QDir dir(index_.directory());
     if (!dir.exists())
         dir.mkpath(".");
 
+    // Full-resolution BGR exists only for frames that get saved
+    if (!loadFullResCurrent() || !currentFrame_.ensureBgr())
+    {
+        QMessageBox::warning(this, "Save failed", "Could not convert the frame.");
+        return;
+    }
+
     // Ensure numbering continues from largest numeric filename
-    recalcNextImageFromDir();
+    // (unless a burst still owns indices that are not on disk yet)
+    index_.rescan();
 
-    // Format: image_XXXX.png (zero-padded to 4 digits)
-    QString filename = QString("image_%1.png")
-                           .arg(nextImageIndex_, 4, 10, QLatin1Char('0'));
+    // Format: image_XXXX.png (zero-padded to 4 digits); content names need no number
+    const int imageIndex = contentNames_ ? 0 : index_.reserve();
+    if (imageIndex < 0)
+    {
+        QMessageBox::warning(this, "Save failed", "Could not reserve an image number: the save directory's "
+                                                  "index is locked by another process.");
+        return;
+    }
 
-    QString fullPath = dir.filePath(filename);
+    SaveJob job;
+    job.frame = currentFrame_.bgr;
+    job.output = output_;
+    job.saveDir = index_.directory();
+    job.contentNamed = contentNames_;
+    if (!contentNames_) job.fileName = index_.relativePathFor(imageIndex);
+    job.sourcePath = lastVideoPath_;
+    job.frameIndex = currentFrameIndex_;
+    job.ptsMs = currentPtsMs_;
+    job.annotations = annotations_.at(currentFrameIndex_);
+    const std::vector<Annotation> suggested = suggestionsToSave(currentFrameIndex_);
+    job.annotations.insert(job.annotations.end(), suggested.begin(), suggested.end());
+    job.classes = labels_;
+    job.annotationFormats = annotationFormats_;
+    if (contentNames_) index_.track(1);     // in flight like a reserved number
+
+    // Encoded, written and synced on the encoder pool like burst frames:
+    // several fsyncs and the shared classes lock stay off the GUI thread
+    const QString videoPath = lastVideoPath_;
+    sink_.submit(std::move(job), [this, videoPath, imageIndex](bool ok, const QString &name) {
+        QMetaObject::invokeMethod(this, [this, ok, videoPath, name, imageIndex]() {
+            onFrameSaved(ok, videoPath, name, imageIndex);
+        }, Qt::QueuedConnection);
+    });
+    statusBar()->showMessage("Saving...", 2000);
+}
 
-    // Save as PNG
-    bool ok = cv::imwrite(fullPath.toStdString(), currentFrameBGR_);
+void MainWindow::onFrameSaved(bool ok, const QString &videoPath, const QString &fileName, int imageIndex)
+{
+    index_.release();
     if (!ok)
     {
+        // Give the number back unless a later save reserved past it meanwhile
+        if (imageIndex > 0 && index_.nextIndex() == imageIndex + 1) index_.setNextIndex(imageIndex);
+        updateInfoLabels();
         QMessageBox::warning(this, "Save failed", "Could not save image.");
         return;
     }
 
-    ++nextImageIndex_;
     updateInfoLabels();
     saveConfig();
+    progress_.addSaved(videoPath);
 
     flashNextImageLabel();
-    statusBar()->showMessage(QString("Saved: %1").arg(filename), 3000);  // shows for 4 seconds
+    statusBar()->showMessage(QString("Saved: %1").arg(fileName), 3000);
 }
 
-void MainWindow::recalcNextImageFromDir()
+void MainWindow::setSaveDirectory(const QString &dir)
 {
-    if (saveDirPath_.isEmpty())
+    // Roll back saves a crashed session left half written, before numbering
+    // continues after them. Not while a burst still writes there.
+    if (index_.pending() == 0)
     {
-        nextImageIndex_ = 1;
+        const SaveJournal::Recovery r = SaveJournal::recover(dir);
+        if (r.removedSaves > 0 || r.removedParts > 0)
+            statusBar()->showMessage(QString("Recovered save directory: removed %1 incomplete image(s), %2 temp file(s)")
+                                         .arg(r.removedSaves).arg(r.removedParts), 6000);
+    }
+    index_.setDirectory(dir);   // rescans
+}
+
+void MainWindow::startBurst()
+{
+    if (!source_.isOpen()) return;
+
+    if (!index_.hasDirectory())
+    {
+        QMessageBox::information(this, "Save directory required", "Please select a save directory first.");
         return;
     }
-    nextImageIndex_ = extractLargestNumberInDir(saveDirPath_) + 1;
+    if (burstFuture_.isRunning())
+    {
+        statusBar()->showMessage("Burst already running", 2000);
+        return;
+    }
+    if (!index_.isWritable())
+    {
+        QMessageBox::warning(this, "Burst failed", "The save directory is not writable.");
+        return;
+    }
+
+    const int stride = std::max(1, burstStride_);
+    const int first = std::max(0, currentFrameIndex_ - burstRadius_);
+    const int last  = std::min(std::max(0, source_.frameCount() - 1), currentFrameIndex_ + burstRadius_);
+    const int count = (last - first) / stride + 1;
+
+    QDir().mkpath(index_.directory());
+
+    // Reserve the whole index range up front; encoders finish out of order
+    const bool contentNamed = contentNames_;
+    QStringList names;          // per the layout at reservation time
+    if (contentNamed)
+        index_.track(count);
+    else
+    {
+        index_.rescan();
+        const int firstImage = index_.reserve(count);
+        if (firstImage < 0)
+        {
+            QMessageBox::warning(this, "Burst failed", "Could not reserve image numbers: the save directory's "
+                                                       "index is locked by another process.");
+            return;
+        }
+        for (int i = 0; i < count; ++i)
+            names << index_.relativePathFor(firstImage + i);
+    }
+    updateInfoLabels();
+    saveConfig();
+
+    auto cancel = std::make_shared<std::atomic_bool>(false);
+    burstCancel_ = cancel;
+
+    const QString videoPath = source_.path();
+    const QString saveDir = index_.directory();
+    const OutputSettings output = output_;
+    const VideoTimeline timeline = source_.timeline();
+    const DecodeOptions decode = source_.options();
+    const AnnotationSet annotations = annotations_;
+    QHash<int, std::vector<Annotation>> suggested;
+    for (int i = first; i <= last && saveSuggestions_; i += stride)
+    {
+        std::vector<Annotation> s = suggestionsToSave(i);
+        if (!s.empty()) suggested.insert(i, std::move(s));
+    }
+    const QStringList classes = labels_;
+    const int formats = annotationFormats_;
+
+    statusBar()->showMessage(QString("Burst: saving %1 frames...").arg(count));
+
+    burstFuture_ = QtConcurrent::run([this, cancel, videoPath, saveDir, output, timeline, decode,
+                                      first, last, stride, count, names, contentNamed,
+                                      annotations, suggested, classes, formats]() {
+        VDT_TRACE_THREAD("burst decoder");
+
+        // Own decoder so playback is untouched; the sink bounds what is in flight
+        VideoSource source;
+        source.setOptions(decode);
+        int produced = 0;
+        if (source.open(videoPath))
+        {
+            source.setTimeline(timeline);
+            source.decodeRange(first, last, stride, cancel.get(), [&](DecodedFrame &&f) {
+                if (produced >= count || !f.ensureBgr()) return;
+
+                SaveJob job;
+                job.frame = std::move(f.bgr);
+                job.output = output;
+                job.saveDir = saveDir;
+                job.contentNamed = contentNamed;
+                if (!contentNamed) job.fileName = names[produced];
+                job.sourcePath = videoPath;
+                job.frameIndex = f.index;
+                job.ptsMs = f.ptsMs;
+                job.annotations = annotations.at(f.index);
+                const std::vector<Annotation> s = suggested.value(f.index);
+                job.annotations.insert(job.annotations.end(), s.begin(), s.end());
+                job.classes = classes;
+                job.annotationFormats = formats;
+                ++produced;
+
+                sink_.submit(std::move(job), [this, videoPath](bool ok, const QString &name) {
+                    QMetaObject::invokeMethod(this, [this, ok, videoPath, name]() {
+                        onBurstFrameSaved(ok, videoPath, name);
+                    }, Qt::QueuedConnection);
+                });
+            });
+        }
+
+        if (produced < count)
+        {
+            QMetaObject::invokeMethod(this, [this, unused = count - produced]() {
+                releaseReservedSaves(unused);
+            }, Qt::QueuedConnection);
+        }
+    });
 }
 
-int MainWindow::extractLargestNumberInDir(const QString &dirPath)
+void MainWindow::onBurstFrameSaved(bool ok, const QString &videoPath, const QString &fileName)
 {
-    QDir dir(dirPath);
-    if (!dir.exists()) return 0;
+    if (!ok)
+        statusBar()->showMessage(QString("Burst: could not save %1").arg(fileName), 3000);
+    else
+    {
+        statusBar()->showMessage(QString("Burst: saved %1 (%2 left)").arg(fileName).arg(index_.pending() - 1), 3000);
+        progress_.addSaved(videoPath);
+    }
+    releaseReservedSaves(1);
+}
 
-    QStringList filters;
-    filters << "*.jpg" << "*.jpeg" << "*.png" << "*.bmp";
-    QFileInfoList list = dir.entryInfoList(filters, QDir::Files | QDir::NoSymLinks | QDir::Readable);
+void MainWindow::releaseReservedSaves(int count)
+{
+    index_.release(count);
+    if (index_.pending() == 0)
+        flashNextImageLabel();
+}
 
-    int maxNum = 0;
-    QRegularExpression re("(\\d+)");
-    for (const QFileInfo &fi : list)
+void MainWindow::promptBurstSettings()
+{
+    bool ok = false;
+    const int radius = QInputDialog::getInt(this, "Burst capture",
+                                            "Frames before and after the current one:",
+                                            burstRadius_, 0, 10000, 1, &ok);
+    if (!ok) return;
+    const int stride = QInputDialog::getInt(this, "Burst capture",
+                                            "Save every Nth frame of that range:",
+                                            burstStride_, 1, 10000, 1, &ok);
+    if (!ok) return;
+
+    burstRadius_ = radius;
+    burstStride_ = stride;
+    saveConfig();
+}
+
+// ================== Annotations ==================
+
+void MainWindow::setupAnnotateMenu()
+{
+    QMenu *annotate = ui->menubar->addMenu("&Annotate");
+
+    annotateAction_ = annotate->addAction("Annotation mode (A)");
+    annotateAction_->setCheckable(true);
+    connect(annotateAction_, &QAction::toggled, this, &MainWindow::setAnnotating);
+    annotate->addAction("Label... (L)", this, &MainWindow::promptLabel);
+    annotate->addAction("Delete selected keyframe / track (Del)", this, &MainWindow::deleteSelectedAnnotation);
+    annotate->addAction("Clear annotations of this video", this, &MainWindow::clearAnnotations);
+    annotate->addSeparator();
+    annotate->addAction("Track selected forward (T)", this, [this]() { trackSelected(+1); });
+    annotate->addAction("Track selected backward (Shift+T)", this, [this]() { trackSelected(-1); });
+    annotate->addAction("Stop tracking", this, &MainWindow::stopTracking);
+    annotate->addSeparator();
+    annotate->addAction("Pre-label model (ONNX)...", this, &MainWindow::choosePrelabelModel);
+    annotate->addAction("Turn pre-labelling off", this, [this]() { setPrelabelModel(QString()); });
+    annotate->addAction("Accept suggestions on this frame (Y)", this, &MainWindow::acceptSuggestions);
+    saveSuggestionsAction_ = annotate->addAction("Save suggestions with frames");
+    saveSuggestionsAction_->setCheckable(true);
+    connect(saveSuggestionsAction_, &QAction::toggled, this, [this](bool on) {
+        saveSuggestions_ = on;
+        saveConfig();
+    });
+    annotate->addSeparator();
+
+    auto addFormat = [this, annotate](const QString &text, int flag) {
+        QAction *a = annotate->addAction(text);
+        a->setCheckable(true);
+        connect(a, &QAction::toggled, this, [this, flag](bool on) {
+            annotationFormats_ = on ? (annotationFormats_ | flag) : (annotationFormats_ & ~flag);
+            saveConfig();
+        });
+        return a;
+    };
+    yoloAction_ = addFormat("Export YOLO labels (.txt)", AnnotationYolo);
+    cocoAction_ = addFormat("Export COCO annotations (.json)", AnnotationCoco);
+}
+
+void MainWindow::setAnnotating(bool on)
+{
+    annotating_ = on;
+    if (on && playing_) setPlaying(false);
+    if (!on) selectedTrack_ = 0;
+    refreshOverlay();
+    statusBar()->showMessage(on ? QString("Annotating as \"%1\": drag = box, Shift+click = point, click = select")
+                                      .arg(currentLabel_.isEmpty() ? QString("?") : currentLabel_)
+                                : QString("Annotation mode off"), 4000);
+}
+
+bool MainWindow::promptLabel()
+{
+    bool ok = false;
+    const QString label = QInputDialog::getItem(this, "Label", "Label for new boxes / points:",
+                                                labels_, std::max(0, labels_.indexOf(currentLabel_)), true, &ok)
+                              .trimmed().remove('|');
+    if (!ok || label.isEmpty()) return false;
+
+    currentLabel_ = label;
+    if (!labels_.contains(label)) labels_ << label;     // appended: existing class ids stay valid
+    saveConfig();
+    return true;
+}
+
+cv::Point2d MainWindow::labelToFrame(const QPoint &p) const
+{
+    const QRect shown = displayedFrameRect();
+    const cv::Size full = currentFrame_.size();
+    if (shown.isEmpty()) return cv::Point2d();
+    return cv::Point2d((p.x() - shown.x()) * static_cast<double>(full.width) / shown.width(),
+                       (p.y() - shown.y()) * static_cast<double>(full.height) / shown.height());
+}
+
+void MainWindow::finishBoxDrag(const QRect &band, const QPoint &click, Qt::KeyboardModifiers mods)
+{
+    const QRect shown = displayedFrameRect();
+    if (shown.isEmpty()) return;
+    const QRect sel = band.intersected(shown);
+    const int frame = currentFrameIndex_;
+
+    if (sel.width() < 4 || sel.height() < 4)
     {
-        const QString base = fi.completeBaseName(); // without extension
-        QRegularExpressionMatchIterator it = re.globalMatch(base);
-        while (it.hasNext())
+        const cv::Point2d p = labelToFrame(click);
+        if (!(mods & Qt::ShiftModifier))
         {
-            QRegularExpressionMatch m = it.next();
-            bool ok = false;
-            int num = m.captured(1).toInt(&ok);
-            if (ok) maxNum = std::max(maxNum, num);
+            // Plain click: select (8 display pixels of slack for points)
+            const double radius = 8.0 * currentFrame_.size().width / shown.width();
+            selectedTrack_ = annotations_.trackAt(frame, p, radius);
+            refreshOverlay();
+            return;
         }
+        // Shift+click: keyframe the selected point track here, or start a new one
+        if (!annotations_.isPointTrack(selectedTrack_))
+        {
+            if (currentLabel_.isEmpty() && !promptLabel()) return;
+            selectedTrack_ = annotations_.addTrack(currentLabel_);
+        }
+        annotations_.setKey(selectedTrack_, frame, cv::Rect2d(p.x, p.y, 0.0, 0.0));
+    }
+    else
+    {
+        const cv::Point2d tl = labelToFrame(sel.topLeft());
+        const cv::Point2d br = labelToFrame(sel.bottomRight() + QPoint(1, 1));
+        const cv::Rect2d box(tl, br);
+        if (!annotations_.hasTrack(selectedTrack_) || annotations_.isPointTrack(selectedTrack_))
+        {
+            if (currentLabel_.isEmpty() && !promptLabel()) return;
+            selectedTrack_ = annotations_.addTrack(currentLabel_);
+        }
+        annotations_.setKey(selectedTrack_, frame, box);
     }
-    return maxNum;
+    saveAnnotations();
+    refreshOverlay();
 }
 
-// ================== Config TXT ==================
+void MainWindow::deleteSelectedAnnotation()
+{
+    if (!annotations_.hasTrack(selectedTrack_)) return;
+    // A keyframe here goes first; otherwise the whole track
+    if (!annotations_.removeKey(selectedTrack_, currentFrameIndex_))
+        annotations_.removeTrack(selectedTrack_);
+    if (!annotations_.hasTrack(selectedTrack_)) selectedTrack_ = 0;
+    saveAnnotations();
+    refreshOverlay();
+}
 
-void MainWindow::loadConfig()
+void MainWindow::clearAnnotations()
+{
+    if (annotations_.isEmpty()) return;
+    if (QMessageBox::question(this, "Clear annotations", "Remove every box and point of this video?") != QMessageBox::Yes)
+        return;
+    annotations_.clear();
+    selectedTrack_ = 0;
+    saveAnnotations();
+    refreshOverlay();
+}
+
+QString MainWindow::annotationFile(const QString &videoPath) const
+{
+    // User work: AppData rather than the cache, and keyed by path only so
+    // touching the video does not orphan it
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/annotations";
+    QDir().mkpath(dir);
+    const QByteArray key = QCryptographicHash::hash(QFileInfo(videoPath).absoluteFilePath().toUtf8(),
+                                                    QCryptographicHash::Sha1).toHex();
+    return QDir(dir).filePath(QString::fromLatin1(key) + ".json");
+}
+
+void MainWindow::loadAnnotations()
+{
+    selectedTrack_ = 0;
+    annotations_.load(annotationFile(lastVideoPath_));     // empty if there is none yet
+}
+
+void MainWindow::saveAnnotations()
+{
+    if (!source_.isOpen()) return;
+    annotations_.save(annotationFile(source_.path()));
+}
+
+// ================== Object tracking ==================
+
+void MainWindow::trackSelected(int direction)
+{
+    if (!source_.isOpen()) return;
+
+    cv::Rect2d box;
+    bool found = false;
+    for (const Annotation &a : annotations_.at(currentFrameIndex_))
+    {
+        if (a.track != selectedTrack_ || a.isPoint()) continue;
+        box = a.box;
+        found = true;
+    }
+    if (!found)
+    {
+        statusBar()->showMessage("Select a box on this frame to track", 3000);
+        return;
+    }
+
+    stopTracking();
+    trackFuture_.waitForFinished();
+
+    // The start box anchors this run; drawn keys ahead end it
+    const int track = selectedTrack_;
+    if (!annotations_.hasDrawnKey(track, currentFrameIndex_))
+    {
+        annotations_.setKey(track, currentFrameIndex_, box);
+        saveAnnotations();
+    }
+    std::set<int> drawn;
+    for (int f : annotations_.keyFrames(track))
+        if (f != currentFrameIndex_ && annotations_.hasDrawnKey(track, f)) drawn.insert(f);
+
+    TrackRequest req;
+    req.path = source_.path();
+    req.decode = source_.options();
+    req.timeline = source_.timeline();
+    req.startFrame = currentFrameIndex_;
+    req.box = box;
+    req.direction = direction;
+    req.maxFrames = kTrackMaxFrames;
+
+    auto cancel = std::make_shared<std::atomic_bool>(false);
+    trackCancel_ = cancel;
+
+    statusBar()->showMessage(QString("Tracking \"%1\" %2 (%3)...")
+                                 .arg(annotations_.labelOf(track), direction > 0 ? "forward" : "backward",
+                                      ObjectTracker::trackerName()));
+
+    // Own decoder like bursts: playback and the frame cache are untouched
+    trackFuture_ = QtConcurrent::run([this, cancel, req, track, drawn]() {
+        VDT_TRACE_THREAD("tracker");
+
+        std::vector<std::pair<int, cv::Rect2d>> batch;
+        auto flush = [&]() {
+            if (batch.empty()) return;
+            QMetaObject::invokeMethod(this, [this, path = req.path, track, boxes = std::move(batch)]() {
+                onTrackedBoxes(path, track, boxes);
+            }, Qt::QueuedConnection);
+            batch.clear();
+        };
+
+        int tracked = 0;
+        try
+        {
+            ObjectTracker::run(req, cancel.get(), [&](int frame, const cv::Rect2d &b) {
+                if (drawn.count(frame)) return false;
+                batch.emplace_back(frame, b);
+                ++tracked;
+                if (static_cast<int>(batch.size()) >= kTrackBatch) flush();
+                return true;
+            });
+        }
+        catch (const std::exception &)
+        {
+            // Boxes so far are kept; the run must still report it is over
+        }
+        flush();
+
+        QMetaObject::invokeMethod(this, [this, path = req.path, tracked, cancelled = cancel->load()]() {
+            onTrackingDone(path, tracked, cancelled);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void MainWindow::stopTracking()
+{
+    if (trackCancel_) trackCancel_->store(true);
+}
+
+void MainWindow::onTrackedBoxes(const QString &videoPath, int track,
+                                const std::vector<std::pair<int, cv::Rect2d>> &boxes)
+{
+    if (videoPath != source_.path()) return;
+
+    bool visible = false;
+    for (const auto &b : boxes)
+    {
+        // Never overwrite a box drawn while the tracker was running
+        if (annotations_.hasDrawnKey(track, b.first)) continue;
+        annotations_.setTrackedKey(track, b.first, b.second);
+        visible = visible || b.first == currentFrameIndex_;
+    }
+    if (visible) refreshOverlay();
+}
+
+void MainWindow::onTrackingDone(const QString &videoPath, int tracked, bool cancelled)
+{
+    if (videoPath != source_.path()) return;
+    saveAnnotations();
+    refreshOverlay();
+    statusBar()->showMessage(QString("Tracking %1: %2 frame(s)").arg(cancelled ? "stopped" : "done").arg(tracked), 4000);
+}
+
+// ================== Pre-labelling ==================
+
+void MainWindow::choosePrelabelModel()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Detector model", QFileInfo(prelabelModel_).absolutePath(),
+                                                      "ONNX models (*.onnx)");
+    if (!path.isEmpty()) setPrelabelModel(path);
+}
+
+void MainWindow::setPrelabelModel(const QString &path)
+{
+    QString error;
+    if (!prelabeler_.setModel(path, &error))
+    {
+        statusBar()->showMessage(QString("Could not load %1: %2").arg(QFileInfo(path).fileName(), error), 6000);
+        return;
+    }
+    prelabelModel_ = path;
+    suggestions_.clear();
+    saveConfig();
+
+    if (path.isEmpty())
+        statusBar()->showMessage("Pre-labelling off", 3000);
+    else
+    {
+        statusBar()->showMessage(QString("Pre-labelling with %1").arg(QFileInfo(path).fileName()), 3000);
+        if (!currentFrame_.isEmpty()) requestSuggestions(currentFrameIndex_, currentFrame_.size());
+    }
+    refreshOverlay();
+}
+
+void MainWindow::requestSuggestions(int frame, cv::Size fullSize)
+{
+    if (displayImage_.isNull() || suggestions_.contains(frame) || !prelabeler_.hasModel()) return;
+
+    // The display image is already downscaled; the detector letterboxes it
+    // further, so nothing bigger is worth converting
+    const cv::Mat bgra(displayImage_.height(), displayImage_.width(), CV_8UC4,
+                       const_cast<uchar *>(displayImage_.constBits()), displayImage_.bytesPerLine());
+    cv::Mat bgr;
+    cv::cvtColor(bgra, bgr, cv::COLOR_BGRA2BGR);
+    prelabeler_.submit(source_.path(), frame, bgr, fullSize);
+}
+
+void MainWindow::onSuggestions(const QString &videoPath, int frame, const std::vector<Annotation> &boxes)
+{
+    if (videoPath != source_.path() || !prelabeler_.hasModel()) return;
+    suggestions_.insert(frame, boxes);      // empty too: the frame is not asked for again
+    if (frame == currentFrameIndex_) refreshOverlay();
+}
+
+void MainWindow::acceptSuggestions()
+{
+    const std::vector<Annotation> boxes = suggestions_.value(currentFrameIndex_);
+    if (boxes.empty())
+    {
+        statusBar()->showMessage("No suggestions on this frame", 2000);
+        return;
+    }
+    for (const Annotation &s : boxes)
+    {
+        const int track = annotations_.addTrack(s.label);
+        annotations_.setKey(track, currentFrameIndex_, s.box);
+        if (!labels_.contains(s.label)) labels_ << s.label;
+    }
+    suggestions_[currentFrameIndex_].clear();      // they are annotations now
+    saveAnnotations();
+    saveConfig();
+    refreshOverlay();
+    statusBar()->showMessage(QString("Accepted %1 suggestion(s)").arg(boxes.size()), 3000);
+}
+
+std::vector<Annotation> MainWindow::suggestionsToSave(int frame)
+{
+    if (!saveSuggestions_) return std::vector<Annotation>();
+    const std::vector<Annotation> out = suggestions_.value(frame);
+    for (const Annotation &s : out)
+        if (!labels_.contains(s.label)) labels_ << s.label;     // class id for the export
+    return out;
+}
+
+// ================== Playlist ==================
+
+void MainWindow::setupPlaylistMenu()
+{
+    QMenu *playlist = ui->menubar->addMenu("&Playlist");
+    playlist->addAction("Open folder...", this, &MainWindow::openFolder);
+    playlist->addSeparator();
+    playlist->addAction("Previous video (PgUp)", this, [this]() { openNeighbourVideo(-1); });
+    playlist->addAction("Next video (PgDown)", this, [this]() { openNeighbourVideo(+1); });
+    playlist->addAction("Next unreviewed video (N)", this, &MainWindow::openNextUnreviewed);
+    playlist->addSeparator();
+    reviewedAction_ = playlist->addAction("Reviewed (D)");
+    reviewedAction_->setCheckable(true);
+    connect(reviewedAction_, &QAction::toggled, this, &MainWindow::setCurrentReviewed);
+}
+
+void MainWindow::openFolder()
+{
+    const QString dir = QFileDialog::getExistingDirectory(this, "Open Video Folder",
+                                                          playlist_.folder().isEmpty() ? QDir::homePath() : playlist_.folder());
+    if (dir.isEmpty()) return;
+
+    Playlist list;
+    if (!list.setFolder(dir))
+    {
+        QMessageBox::information(this, "Playlist", "No videos in that folder.");
+        return;
+    }
+    playlist_ = list;
+    openVideo(playlist_.at(0));
+    saveConfig();
+}
+
+void MainWindow::openNeighbourVideo(int delta)
+{
+    const QString path = playlist_.neighbour(delta);
+    if (path.isEmpty())
+    {
+        statusBar()->showMessage(delta > 0 ? "Last video in folder" : "First video in folder", 2000);
+        return;
+    }
+    setPlaying(false);
+    openVideo(path);
+    saveConfig();
+}
+
+void MainWindow::syncPlaylist(const QString &path)
+{
+    // Any opened file makes its folder the playlist
+    int i = playlist_.indexOf(path);
+    if (i < 0)
+    {
+        playlist_.setFolder(QFileInfo(path).absolutePath());
+        i = playlist_.indexOf(path);
+    }
+    playlist_.setCurrent(i);
+}
+
+void MainWindow::recordPosition()
+{
+    if (!source_.isOpen()) return;
+    progress_.setPosition(source_.path(), currentFrameIndex_, currentPtsMs_);
+}
+
+void MainWindow::setCurrentReviewed(bool on)
+{
+    if (!source_.isOpen()) return;
+    progress_.setDone(source_.path(), on);
+    showPlaylistStatus();
+}
+
+void MainWindow::openNextUnreviewed()
+{
+    for (int i = playlist_.current() + 1; i < playlist_.count(); ++i)
+    {
+        if (progress_.get(playlist_.at(i)).done) continue;
+        setPlaying(false);
+        openVideo(playlist_.at(i));
+        saveConfig();
+        return;
+    }
+    statusBar()->showMessage("No unreviewed videos after this one", 2000);
+}
+
+void MainWindow::showPlaylistStatus()
+{
+    if (playlist_.current() < 0) return;
+    int reviewed = 0;
+    for (int i = 0; i < playlist_.count(); ++i)
+        if (progress_.get(playlist_.at(i)).done) ++reviewed;
+
+    const VideoProgress p = progress_.get(source_.path());
+    statusBar()->showMessage(QString("Video %1 / %2 • %3 reviewed • %4 frames saved from this one")
+                                 .arg(playlist_.current() + 1).arg(playlist_.count())
+                                 .arg(reviewed).arg(p.savedFrames), 4000);
+}
+
+void MainWindow::startPrefetch()
+{
+    // Forward is the common direction through a folder
+    const QString next = playlist_.neighbour(+1);
+    if (next.isEmpty() || next == prefetchPath_) return;
+
+    if (prefetchCancel_) prefetchCancel_->store(true);
+    auto cancel = std::make_shared<std::atomic_bool>(false);
+    prefetchCancel_ = cancel;
+    prefetchPath_ = next;
+
+    const DecodeOptions opt = effectiveDecodeOptions();
+    const QString timelineDir = cacheDir("timelines");
+    prefetchWatcher_.setFuture(QtConcurrent::run([next, opt, timelineDir, cancel]() {
+        VDT_TRACE_THREAD("prefetch");
+        return prepareVideo(next, opt, timelineDir, cancel.get());
+    }));
+}
+
+std::shared_ptr<PreparedVideo> MainWindow::takePrefetched(const QString &path)
+{
+    if (path != prefetchPath_ || prefetchCancel_->load()) return nullptr;
+    prefetchPath_.clear();
+
+    // Still opening: finishing it is never slower than starting over
+    prefetchWatcher_.waitForFinished();
+    std::shared_ptr<PreparedVideo> p = prefetchWatcher_.result();
+    if (!p || p->options != effectiveDecodeOptions()) return nullptr;
+    return p;
+}
+
+QString MainWindow::cacheDir(const QString &name) const
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/" + name;
+    QDir().mkpath(dir);
+    return dir;
+}
+
+// ================== Decode Backend ==================
+
+void MainWindow::setupDecodeMenu()
+{
+    QMenu *decode = ui->menubar->addMenu("&Decode");
+
+    backendMenu_ = decode->addMenu("Backend");
+    decode->addAction("Probe backends now", this, [this]() {
+        if (!source_.isOpen()) return;
+        statusBar()->showMessage("Probing decode backends...");
+        startBackendProbe(source_.path());
+    });
+
+    decode->addSeparator();
+    decode->addAction("Decoder threads...", this, &MainWindow::promptDecodeThreads);
+    hwAccelAction_ = decode->addAction("Hardware decoding");
+    hwAccelAction_->setCheckable(true);
+    connect(hwAccelAction_, &QAction::toggled, this, [this](bool on) {
+        if (decode_.hwAccel == on) return;
+        decode_.hwAccel = on;
+        saveConfig();
+        applyDecodeOptions();
+    });
+
+    decode->addSeparator();
+    proxyAction_ = decode->addAction("Proxy playback (display-size frames)");
+    proxyAction_->setCheckable(true);
+    connect(proxyAction_, &QAction::toggled, this, &MainWindow::setProxyPlayback);
+    proxyFilesAction_ = decode->addAction(QString("Proxy files for videos %1 px and wider").arg(kProxyFileMinWidth));
+    proxyFilesAction_->setCheckable(true);
+    connect(proxyFilesAction_, &QAction::toggled, this, &MainWindow::setProxyFiles);
+    decode->addAction("Delete proxy files", this, &MainWindow::deleteProxyFiles);
+}
+
+void MainWindow::rebuildBackendMenu()
+{
+    // Only called outside the menu's own signal handlers (actions get deleted)
+    backendMenu_->clear();
+    delete backendGroup_;
+    backendGroup_ = new QActionGroup(this);
+
+    auto addChoice = [this](const QString &text, bool checked, bool automatic, int api) {
+        QAction *a = backendMenu_->addAction(text);
+        a->setCheckable(true);
+        a->setChecked(checked);
+        backendGroup_->addAction(a);
+        connect(a, &QAction::triggered, this, [this, automatic, api]() {
+            decodeAuto_ = automatic;
+            if (!automatic) decode_.api = api;
+            saveConfig();
+            applyDecodeOptions();
+        });
+    };
+
+    const QString fastest = probedBackend_ != cv::CAP_ANY ? backendName(probedBackend_) : QString("not probed yet");
+    addChoice(QString("Fastest measured (%1)").arg(fastest), decodeAuto_, true, cv::CAP_ANY);
+    addChoice("OpenCV default", !decodeAuto_ && decode_.api == cv::CAP_ANY, false, cv::CAP_ANY);
+    backendMenu_->addSeparator();
+
+    for (int api : availableFileBackends())
+    {
+        QString text = backendName(api);
+        for (const BackendProbe &p : probes_)
+        {
+            if (p.api != api) continue;
+            text += p.decodeFps > 0.0 ? QString("  (%1 fps)").arg(p.decodeFps, 0, 'f', 0)
+                                      : QString("  (failed)");
+        }
+        addChoice(text, !decodeAuto_ && decode_.api == api, false, api);
+    }
+}
+
+DecodeOptions MainWindow::effectiveDecodeOptions() const
+{
+    DecodeOptions opt = decode_;
+    if (decodeAuto_) opt.api = probedBackend_;
+    return opt;
+}
+
+void MainWindow::applyDecodeOptions()
+{
+    if (!source_.isOpen()) return;
+
+    const QString path = source_.path();
+    const VideoTimeline timeline = source_.timeline();
+    const int index = currentFrameIndex_;
+
+    if (!openSource(path))
+    {
+        QMessageBox::warning(this, "Error", "Failed to reopen video with the selected decoder.");
+        return;
+    }
+    // Keep the scanned PTS table; an estimate is replaced when the scan lands
+    if (timeline.isExact()) source_.setTimeline(timeline);
+    cache_.clear();
+    startProxyFile();
+    seekTo(index);
+
+    statusBar()->showMessage(QString("Decoding with %1").arg(source_.backendName()), 3000);
+}
+
+QString MainWindow::probeKeyFor() const
+{
+    const cv::Size size = source_.frameSize();
+    return QString("%1 %2x%3").arg(source_.codecName()).arg(size.width).arg(size.height);
+}
+
+void MainWindow::autoSelectBackend()
+{
+    auto it = probeCache_.constFind(probeKeyFor());
+    if (it == probeCache_.constEnd())
+    {
+        startBackendProbe(source_.path());
+        return;
+    }
+
+    // Measured on an earlier clip of the same kind this session
+    probes_ = *it;
+    const int fastest = fastestBackend(probes_);
+    if (fastest != cv::CAP_ANY && fastest != probedBackend_)
+    {
+        probedBackend_ = fastest;
+        rebuildBackendMenu();
+        saveConfig();
+    }
+    if (source_.options().api != probedBackend_)
+        applyDecodeOptions();
+}
+
+void MainWindow::startBackendProbe(const QString &path)
+{
+    if (probeCancel_) probeCancel_->store(true);
+    auto cancel = std::make_shared<std::atomic_bool>(false);
+    probeCancel_ = cancel;
+    probeKey_ = probeKeyFor();
+
+    const DecodeOptions opt = decode_;
+    probeWatcher_.setFuture(QtConcurrent::run([path, opt, cancel]() {
+        return probeBackends(path, opt, kProbeFrames, cancel.get());
+    }));
+}
+
+void MainWindow::onBackendsProbed()
+{
+    std::vector<BackendProbe> probes = probeWatcher_.result();
+    if (probes.empty() || probeCancel_->load()) return;
+
+    QStringList report;
+    for (const BackendProbe &p : probes)
+    {
+        report << (p.decodeFps > 0.0 ? QString("%1 %2 fps").arg(p.name).arg(p.decodeFps, 0, 'f', 0)
+                                     : QString("%1 failed").arg(p.name));
+    }
+    statusBar()->showMessage("Decode backends: " + report.join(" • "), 6000);
+
+    probeCache_.insert(probeKey_, probes);
+    // Another kind of clip was opened meanwhile: it gets its own probe
+    if (probeKey_ != probeKeyFor()) return;
+
+    probes_ = std::move(probes);
+    const int fastest = fastestBackend(probes_);
+    if (fastest != cv::CAP_ANY) probedBackend_ = fastest;
+    rebuildBackendMenu();
+    saveConfig();
+
+    if (decodeAuto_ && source_.isOpen() && source_.options().api != probedBackend_)
+        applyDecodeOptions();
+}
+
+void MainWindow::setProxyPlayback(bool on)
+{
+    if (proxyPlayback_ == on) return;
+    proxyPlayback_ = on;
+    // Cached frames are the other representation now
+    cache_.clear();
+    updateProxySize();
+    saveConfig();
+}
+
+void MainWindow::updateProxySize()
+{
+    const QSize area = ui->videoLabel->size();
+    const cv::Size proxy = proxyPlayback_ ? cv::Size(area.width(), area.height()) : cv::Size();
+    if (proxy != source_.proxySize())
+    {
+        source_.setProxySize(proxy);
+        // Cached proxies were decoded for the old size and would be shown at it
+        cache_.clear();
+    }
+    if (currentFrame_.isProxy() && !playing_)
+        fullResTimer_.start(kFullResDelayMs);
+}
+
+void MainWindow::onFullResTimeout()
+{
+    // Still moving: the next resting frame gets it
+    if (playing_ || sliderHeld_ || !currentFrame_.isProxy()) return;
+    if (loadFullResCurrent())
+        displayFrame(currentFrame_);
+}
+
+bool MainWindow::loadFullResCurrent()
 {
-    QFile f(configPath_);
-    if (!f.exists()) return;
-    if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) return;
+    if (!currentFrame_.isProxy()) return true;
+    DecodedFrame full;
+    if (!source_.retrieveFull(currentFrameIndex_, full)) return false;
+    currentFrame_ = full;          // not cached: only the resting frame is kept at full size
+    return true;
+}
 
-    QTextStream in(&f);
-    while (!in.atEnd())
+void MainWindow::setProxyFiles(bool on)
+{
+    if (proxyFiles_ == on) return;
+    proxyFiles_ = on;
+    saveConfig();
+    if (on)
     {
-        const QString line = in.readLine().trimmed();
-        if (line.isEmpty() || line.startsWith('#')) continue;
-        const int eq = line.indexOf('=');
-        if (eq <= 0) continue;
+        startProxyFile();
+        return;
+    }
+    if (proxyBuildCancel_) proxyBuildCancel_->store(true);
+    if (source_.hasProxyFile())
+    {
+        source_.detachProxyFile();
+        cache_.clear();
+        seekTo(currentFrameIndex_);
+    }
+}
 
-        const QString key = line.left(eq).trimmed();
-        const QString val = line.mid(eq + 1).trimmed();
+void MainWindow::startProxyFile()
+{
+    if (!proxyFiles_ || !source_.isOpen() || source_.hasProxyFile()) return;
+    if (source_.frameSize().width < kProxyFileMinWidth) return;
 
-        if (key == "last_video") lastVideoPath_ = val;
-        else if (key == "save_dir") saveDirPath_ = val;
-        else if (key == "next_image") nextImageIndex_ = val.toInt();
+    const QString path = source_.path();
+    const QString target = proxyFilePathFor(path, cacheDir("proxies"));
+    if (QFile::exists(target))
+    {
+        if (attachProxyFile(target)) return;
+        QFile::remove(target);          // stale or truncated: build it again
     }
-    f.close();
+    if (proxyBuildWatcher_.isRunning() && proxyBuildSource_ == path) return;
+
+    if (proxyBuildCancel_) proxyBuildCancel_->store(true);
+    auto cancel = std::make_shared<std::atomic_bool>(false);
+    proxyBuildCancel_ = cancel;
+    proxyBuildSource_ = path;
+    proxyBuildTarget_ = target;
+    statusBar()->showMessage("Building proxy file in the background...", 3000);
+
+    // The previous build (cancelled above) stops at its next frame
+    proxyBuildWatcher_.waitForFinished();
+    const DecodeOptions opt = source_.options();
+    proxyBuildWatcher_.setFuture(QtConcurrent::run([path, target, opt, cancel]() {
+        VDT_TRACE_THREAD("proxy builder");
+        return buildProxyFile(path, target, opt, cancel.get());
+    }));
 }
 
-void MainWindow::saveConfig() const
+void MainWindow::onProxyFileBuilt()
 {
-    QFile f(configPath_);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Text)) return;
+    if (!proxyBuildWatcher_.result() || proxyBuildCancel_->load()) return;
+    // The user may have moved on to another video meanwhile
+    if (!proxyFiles_ || source_.path() != proxyBuildSource_ || source_.hasProxyFile()) return;
+
+    if (attachProxyFile(proxyBuildTarget_))
+        statusBar()->showMessage("Navigating on proxy file", 3000);
+    else
+        QFile::remove(proxyBuildTarget_);
+}
 
-    QTextStream out(&f);
-    out << "# Simple config for Video Dataset Preparation Tool\n";
-    out << "last_video=" << lastVideoPath_ << "\n";
-    out << "save_dir="   << saveDirPath_   << "\n";
-    out << "next_image=" << nextImageIndex_ << "\n";
-    f.close();
+bool MainWindow::attachProxyFile(const QString &file)
+{
+    if (!source_.attachProxyFile(file)) return false;
+    // Cached frames came from the original decoder
+    cache_.clear();
+    seekTo(currentFrameIndex_);
+    return true;
+}
+
+void MainWindow::deleteProxyFiles()
+{
+    if (proxyBuildCancel_) proxyBuildCancel_->store(true);
+    proxyBuildWatcher_.waitForFinished();
+    if (source_.hasProxyFile())
+    {
+        source_.detachProxyFile();
+        cache_.clear();
+        seekTo(currentFrameIndex_);
+    }
+    QDir(cacheDir("proxies")).removeRecursively();
+    statusBar()->showMessage("Proxy files deleted", 3000);
+}
+
+void MainWindow::promptDecodeThreads()
+{
+    bool ok = false;
+    const int threads = QInputDialog::getInt(this, "Decoder threads",
+                                             "Threads per decoder (0 = backend default):",
+                                             decode_.threads, 0, 64, 1, &ok);
+    if (!ok || threads == decode_.threads) return;
+
+    decode_.threads = threads;
+    saveConfig();
+    applyDecodeOptions();
+}
+
+// ================== Config TXT ==================
+
+void MainWindow::loadConfig()
+{
+    if (!config_.load()) return;
+
+    lastVideoPath_ = config_.value("last_video");
+    index_.setNextIndex(config_.intValue("next_image", 1));
+    setSaveDirectory(config_.value("save_dir"));
+
+    const QStringList roi = config_.value("roi").split(',');
+    if (roi.size() == 4)
+        output_.roi = cv::Rect(roi[0].toInt(), roi[1].toInt(), roi[2].toInt(), roi[3].toInt());
+    const QStringList size = config_.value("output_size").split('x');
+    if (size.size() == 2)
+        output_.size = cv::Size(size[0].toInt(), size[1].toInt());
+    output_.grayscale = config_.value("grayscale") == "1";
+    contentNames_ = config_.value("save_naming") == "hash";
+    index_.setShardSize(config_.intValue("save_shard", 0));
+    labels_ = config_.value("labels").split('|', Qt::SkipEmptyParts);
+    currentLabel_ = config_.value("annot_label");
+    annotationFormats_ = config_.intValue("annot_export", AnnotationYolo);
+    prelabelModel_ = config_.value("prelabel_model");
+    saveSuggestions_ = config_.value("prelabel_save") == "1";
+    hudEnabled_ = config_.value("hud") == "1";
+    burstRadius_ = std::max(0, config_.intValue("burst_radius", burstRadius_));
+    burstStride_ = std::max(1, config_.intValue("burst_stride", burstStride_));
+
+    output_.pyramidWidths.clear();
+    for (const QString &w : config_.value("pyramid").split(',', Qt::SkipEmptyParts))
+        if (w.toInt() > 0) output_.pyramidWidths.push_back(w.toInt());
+
+    // Backends missing from this OpenCV build fall back to its default
+    const QString backend = config_.value("decode_backend", "auto");
+    decodeAuto_ = (backend == "auto");
+    if (!decodeAuto_) decode_.api = std::max(0, backendFromName(backend));
+    probedBackend_ = std::max(0, backendFromName(config_.value("decode_probed", "Default")));
+    decode_.threads = std::max(0, config_.intValue("decode_threads", 0));
+    decode_.hwAccel = config_.value("decode_hwaccel") == "1";
+    proxyPlayback_ = config_.value("proxy_playback") == "1";
+    proxyFiles_ = config_.value("proxy_files") == "1";
+}
+
+void MainWindow::saveConfig()
+{
+    config_.setValue("last_video", lastVideoPath_);
+    config_.setValue("save_dir", index_.directory());
+    config_.setValue("next_image", index_.nextIndex());
+    config_.setValue("roi", QString("%1,%2,%3,%4").arg(output_.roi.x).arg(output_.roi.y)
+                                                    .arg(output_.roi.width).arg(output_.roi.height));
+    config_.setValue("output_size", QString("%1x%2").arg(output_.size.width).arg(output_.size.height));
+    config_.setValue("grayscale", output_.grayscale ? 1 : 0);
+    config_.setValue("save_naming", contentNames_ ? QString("hash") : QString("sequential"));
+    config_.setValue("save_shard", index_.shardSize());
+    config_.setValue("labels", labels_.join('|'));
+    config_.setValue("annot_label", currentLabel_);
+    config_.setValue("annot_export", annotationFormats_);
+    config_.setValue("prelabel_model", prelabelModel_);
+    config_.setValue("prelabel_save", saveSuggestions_ ? 1 : 0);
+    QStringList widths;
+    for (int w : output_.pyramidWidths) widths << QString::number(w);
+    config_.setValue("pyramid", widths.join(','));
+    config_.setValue("burst_radius", burstRadius_);
+    config_.setValue("burst_stride", burstStride_);
+    config_.setValue("hud", hudEnabled_ ? 1 : 0);
+    config_.setValue("decode_backend", decodeAuto_ ? QString("auto") : backendName(decode_.api));
+    config_.setValue("decode_probed", backendName(probedBackend_));
+    config_.setValue("decode_threads", decode_.threads);
+    config_.setValue("decode_hwaccel", decode_.hwAccel ? 1 : 0);
+    config_.setValue("proxy_playback", proxyPlayback_ ? 1 : 0);
+    config_.setValue("proxy_files", proxyFiles_ ? 1 : 0);
+    config_.saveLater();
 }
 
 // ================== Events ==================
 
 bool MainWindow::eventFilter(QObject *obj, QEvent *event)
 {
+    // Ctrl + left drag on the video => select save ROI
+    if (obj == ui->videoLabel && !currentFrame_.isEmpty())
+    {
+        if (event->type() == QEvent::MouseButtonPress)
+        {
+            auto *me = static_cast<QMouseEvent*>(event);
+            if (me->button() == Qt::LeftButton && (me->modifiers() & Qt::ControlModifier)) {
+                roiDragging_ = true;
+                roiOrigin_ = me->position().toPoint();
+                roiBand_->setGeometry(QRect(roiOrigin_, QSize()));
+                roiBand_->show();
+                return true;
+            }
+            // Annotation mode: left drag draws a box, a click selects / adds a point
+            if (me->button() == Qt::LeftButton && annotating_) {
+                boxDragging_ = true;
+                roiOrigin_ = me->position().toPoint();
+                roiBand_->setGeometry(QRect(roiOrigin_, QSize()));
+                roiBand_->show();
+                return true;
+            }
+        }
+        else if (event->type() == QEvent::MouseMove && (roiDragging_ || boxDragging_))
+        {
+            auto *me = static_cast<QMouseEvent*>(event);
+            roiBand_->setGeometry(QRect(roiOrigin_, me->position().toPoint()).normalized());
+            return true;
+        }
+        else if (event->type() == QEvent::MouseButtonRelease && boxDragging_)
+        {
+            auto *me = static_cast<QMouseEvent*>(event);
+            boxDragging_ = false;
+            roiBand_->hide();
+            finishBoxDrag(roiBand_->geometry(), me->position().toPoint(), me->modifiers());
+            return true;
+        }
+        else if (event->type() == QEvent::MouseButtonRelease && roiDragging_)
+        {
+            roiDragging_ = false;
+            roiBand_->hide();
+
+            // Map from label pixels to frame pixels
+            const QRect shown = displayedFrameRect();
+            const QRect sel = roiBand_->geometry().intersected(shown);
+            if (sel.width() < 4 || sel.height() < 4 || shown.isEmpty()) {
+                clearRoi();   // a click without a real drag resets the ROI
+                return true;
+            }
+            const cv::Size full = currentFrame_.size();
+            const double sx = static_cast<double>(full.width) / shown.width();
+            const double sy = static_cast<double>(full.height) / shown.height();
+            output_.roi = cv::Rect(static_cast<int>((sel.x() - shown.x()) * sx),
+                                   static_cast<int>((sel.y() - shown.y()) * sy),
+                                   static_cast<int>(sel.width() * sx),
+                                   static_cast<int>(sel.height() * sy))
+                          & cv::Rect(0, 0, full.width, full.height);
+            refreshOverlay();
+            saveConfig();
+            statusBar()->showMessage(QString("ROI: %1x%2 at (%3, %4)")
+                                         .arg(output_.roi.width).arg(output_.roi.height)
+                                         .arg(output_.roi.x).arg(output_.roi.y), 3000);
+            return true;
+        }
+    }
+
+    // Time the real repaint of the video surface for the HUD
+    if (obj == ui->videoLabel && event->type() == QEvent::Paint && !inVideoPaint_)
+    {
+        inVideoPaint_ = true;
+        {
+            PerfScope t(perf_, PerfStats::Paint);
+            VDT_TRACE_SCOPE("paint");
+            obj->event(event);
+        }
+        inVideoPaint_ = false;
+        return true;
+    }
+
     // Handle mouse click on the video label to toggle play/pause
     if (obj == ui->videoLabel && event->type() == QEvent::MouseButtonPress)
     {
@@ -509,8 +2044,8 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
         }
     }
 
-    // Handle keys globally (installed on qApp)
-    if (event->type() == QEvent::KeyPress)
+    // Handle keys globally (installed on qApp), but leave dialogs alone
+    if (event->type() == QEvent::KeyPress && !QApplication::activeModalWidget())
     {
         auto *ke = static_cast<QKeyEvent*>(event);
 
@@ -526,16 +2061,75 @@ bool MainWindow::eventFilter(QObject *obj, QEvent *event)
             return true; // consume
         }
 
+        // 'H' => performance HUD
+        if (ke->key() == Qt::Key_H) {
+            setHudVisible(!hudAction_->isChecked());
+            return true;
+        }
+
+        // 'B' => burst-save the frames around the current one
+        if (ke->key() == Qt::Key_B) {
+            startBurst();
+            return true;
+        }
+
+        // 'D' => toggle reviewed, 'N' => next unreviewed video
+        if (ke->key() == Qt::Key_D) {
+            reviewedAction_->toggle();
+            return true;
+        }
+        if (ke->key() == Qt::Key_N) {
+            openNextUnreviewed();
+            return true;
+        }
+
+        // 'A' => annotation mode, 'L' => label; Del / Esc act on the selected track
+        if (ke->key() == Qt::Key_A) {
+            annotateAction_->toggle();
+            return true;
+        }
+        if (ke->key() == Qt::Key_L) {
+            promptLabel();
+            return true;
+        }
+        if (annotating_ && ke->key() == Qt::Key_Delete) {
+            deleteSelectedAnnotation();
+            return true;
+        }
+        // 'Y' => accept the detector's suggestions on this frame
+        if (ke->key() == Qt::Key_Y) {
+            acceptSuggestions();
+            return true;
+        }
+
+        // 'T' => track the selected box forward, Shift+T backward
+        if (ke->key() == Qt::Key_T) {
+            trackSelected(ke->modifiers() & Qt::ShiftModifier ? -1 : +1);
+            return true;
+        }
+        if (annotating_ && ke->key() == Qt::Key_Escape) {
+            stopTracking();
+            selectedTrack_ = 0;
+            refreshOverlay();
+            return true;
+        }
+
+        // PgUp / PgDown => previous / next video in the folder
+        if (ke->key() == Qt::Key_PageUp || ke->key() == Qt::Key_PageDown) {
+            openNeighbourVideo(ke->key() == Qt::Key_PageDown ? +1 : -1);
+            return true;
+        }
+
         // NEW: Arrow keys step one frame
         if (ke->key() == Qt::Key_Left) {
-            if (cap_.isOpened()) {
+            if (source_.isOpen()) {
                 setPlaying(false);      // ensure paused
                 stepRelative(-1);       // go back one frame
             }
             return true;
         }
         if (ke->key() == Qt::Key_Right) {
-            if (cap_.isOpened()) {
+            if (source_.isOpen()) {
                 setPlaying(false);      // ensure paused
                 stepRelative(+1);       // forward one frame
             }
@@ -564,8 +2158,9 @@ void MainWindow::resizeEvent(QResizeEvent *e)
     }
 
     //rescale the currently shown frame to fit the new size
-    if (!currentFrameBGR_.empty())
-        displayMat(currentFrameBGR_);
+    updateProxySize();
+    if (!currentFrame_.isEmpty())
+        displayFrame(currentFrame_);
 }
 
 
@@ -6,16 +6,42 @@
 #include <QShortcut>
 #include <QFile>
 #include <QDir>
-#include <QRegularExpression>
 
 #include <QTimer>
 #include <QGraphicsOpacityEffect>
 #include <QPropertyAnimation>
 #include <QLabel>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QRubberBand>
 
 #include <opencv2/opencv.hpp>
 
+#include <atomic>
+#include <memory>
+
+#include "annotations.h"
+#include "configstore.h"
+#include "datasetindex.h"
+#include "decodebackend.h"
+#include "displayconvert.h"
+#include "framecache.h"
+#include "frameoutput.h"
+#include "framesink.h"
+#include "objecttracker.h"
+#include "perfstats.h"
+#include "playlist.h"
+#include "prelabeler.h"
+#include "progressstore.h"
+#include "proxyfile.h"
+#include "trace.h"
+#include "videoprefetch.h"
+#include "videosource.h"
+
 QT_BEGIN_NAMESPACE
+class QActionGroup;
+
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
 
@@ -51,30 +77,212 @@ private slots:
 private:
     Ui::MainWindow *ui;
 
+    // Engine (vdt_core); the window only drives it
+    PerfStats perf_;
+    VideoSource source_;
+    FrameCache cache_;
+    FrameSink sink_;
+    DatasetIndex index_;
+    ConfigStore config_;
+    ProgressStore progress_;
+
     // Playback
     QTimer timer_;
-    cv::VideoCapture cap_;
-    double fps_ = 30.0;
-    int frameCount_ = 0;
     int currentFrameIndex_ = 0;
     bool playing_ = false;
     bool sliderHeld_ = false;
 
+    // Timeline (slider, seeks and playback clock work in PTS milliseconds)
+    double currentPtsMs_ = 0.0;
+    QElapsedTimer playClock_;           // wall clock since playback was anchored
+    double playStartPtsMs_ = 0.0;       // media time at the anchor
+    QFutureWatcher<VideoTimeline> timelineWatcher_;
+    std::shared_ptr<std::atomic_bool> timelineCancel_;
+    void startTimelineScan(const QString &path);
+    void onTimelineScanned();
+
+    // Decode backend (Decode menu): picked by hand, or the fastest one measured
+    // against each opened file
+    static constexpr int kProbeFrames = 90;
+    DecodeOptions decode_;
+    bool decodeAuto_ = true;
+    int probedBackend_ = 0;             // CAP_ANY until a probe succeeded
+    std::vector<BackendProbe> probes_;
+    QMenu *backendMenu_ = nullptr;
+    QActionGroup *backendGroup_ = nullptr;
+    QAction *hwAccelAction_ = nullptr;
+    QFutureWatcher<std::vector<BackendProbe>> probeWatcher_;
+    std::shared_ptr<std::atomic_bool> probeCancel_;
+    // Results per codec + frame size for this session, so a folder of
+    // similar clips is probed once rather than per file
+    QHash<QString, std::vector<BackendProbe>> probeCache_;
+    QString probeKey_;                  // of the running probe
+    QString probeKeyFor() const;        // of the open video
+    void autoSelectBackend();
+    void setupDecodeMenu();
+    void rebuildBackendMenu();
+    DecodeOptions effectiveDecodeOptions() const;
+    bool openSource(const QString &path);
+    void applyDecodeOptions();          // reopens the current video at the same frame
+    void startBackendProbe(const QString &path);     // always measures
+    void onBackendsProbed();
+    void promptDecodeThreads();
+
+    // Proxy playback: decode to display size while playing / scrubbing; the
+    // frame the user rests on (and anything saved) is fetched at full size
+    static constexpr int kFullResDelayMs = 150;
+    bool proxyPlayback_ = false;
+    QAction *proxyAction_ = nullptr;
+    QTimer fullResTimer_;
+    void setProxyPlayback(bool on);
+    void updateProxySize();
+    void onFullResTimeout();
+    bool loadFullResCurrent();
+
+    // Proxy files: sources at least kProxyFileMinWidth wide get an all-intra
+    // copy built in the background (cache dir) and navigate on it
+    static constexpr int kProxyFileMinWidth = 2560;
+    bool proxyFiles_ = false;
+    QAction *proxyFilesAction_ = nullptr;
+    QFutureWatcher<bool> proxyBuildWatcher_;
+    std::shared_ptr<std::atomic_bool> proxyBuildCancel_;
+    QString proxyBuildSource_;
+    QString proxyBuildTarget_;
+    void setProxyFiles(bool on);
+    void startProxyFile();
+    void onProxyFileBuilt();
+    bool attachProxyFile(const QString &file);
+    void deleteProxyFiles();
+
+    // Folder playlist (PgUp / PgDown): the next video is opened and decoded
+    // in the background while the current one is reviewed
+    Playlist playlist_;
+    QFutureWatcher<std::shared_ptr<PreparedVideo>> prefetchWatcher_;
+    std::shared_ptr<std::atomic_bool> prefetchCancel_;
+    QString prefetchPath_;
+    QString cacheDir(const QString &name) const;    // per-file caches (proxies, PTS tables)
+    void setupPlaylistMenu();
+    void openFolder();
+    void openNeighbourVideo(int delta);
+    void syncPlaylist(const QString &path);
+    void startPrefetch();
+    std::shared_ptr<PreparedVideo> takePrefetched(const QString &path);
+    // Review progress per video (progress.jsonl): resume position, saved
+    // frame count, reviewed flag
+    // The position is also recorded shortly after a pause or seek, so a crash
+    // keeps it
+    static constexpr int kPositionDelayMs = 1000;
+    QAction *reviewedAction_ = nullptr;
+    QTimer positionTimer_;
+    void recordPosition();
+    void setCurrentReviewed(bool on);
+    void openNextUnreviewed();
+    void showPlaylistStatus();
+
     // Saving / state
     QString lastVideoPath_;
-    QString saveDirPath_;
-    int nextImageIndex_ = 1;
+    void setSaveDirectory(const QString &dir);  // recovers the save journal, rescans
+
+    // Output shaping applied at save time (ROI is Ctrl+drag on the video)
+    OutputSettings output_;
+    QRubberBand *roiBand_ = nullptr;
+    QPoint roiOrigin_;
+    bool roiDragging_ = false;
+    QAction *grayscaleAction_ = nullptr;
+    bool contentNames_ = false;         // ab/cd/<sha256>.png instead of image_XXXX.png
+    QAction *contentNamesAction_ = nullptr;
+    QAction *shardAction_ = nullptr;    // index_ sharded into folders of kDefaultShardSize
+    void setupCaptureMenu();
+    void promptOutputSize();
+    void promptPyramidWidths();
+    void clearRoi();
+    QRect displayedFrameRect() const;   // where the frame sits inside videoLabel
+
+    // Annotations ('A' toggles the mode): drag = box, Shift+click = point,
+    // click = select; a drag with a track selected keyframes that track here.
+    // Kept per video and exported next to every save.
+    AnnotationSet annotations_;
+    QStringList labels_;                // class list; class id = index, only grows
+    QString currentLabel_;
+    int selectedTrack_ = 0;
+    int annotationFormats_ = AnnotationYolo;
+    bool annotating_ = false;
+    bool boxDragging_ = false;
+    QAction *annotateAction_ = nullptr;
+    QAction *yoloAction_ = nullptr;
+    QAction *cocoAction_ = nullptr;
+    void setupAnnotateMenu();
+    void setAnnotating(bool on);
+    bool promptLabel();
+    void finishBoxDrag(const QRect &band, const QPoint &click, Qt::KeyboardModifiers mods);
+    void deleteSelectedAnnotation();
+    void clearAnnotations();
+    QString annotationFile(const QString &videoPath) const;
+    void loadAnnotations();
+    void saveAnnotations();
+    cv::Point2d labelToFrame(const QPoint &p) const;
+
+    // Object tracking (T / Shift+T): the selected box followed forward /
+    // backward on a worker decoder until lost or the next drawn key; results
+    // arrive in batches as tracked keys, so bursts export a box per frame
+    static constexpr int kTrackMaxFrames = 300;
+    static constexpr int kTrackBatch = 10;
+    QFuture<void> trackFuture_;
+    std::shared_ptr<std::atomic_bool> trackCancel_;
+    void trackSelected(int direction);
+    void stopTracking();
+    void onTrackedBoxes(const QString &videoPath, int track, const std::vector<std::pair<int, cv::Rect2d>> &boxes);
+    void onTrackingDone(const QString &videoPath, int tracked, bool cancelled);
+
+    // Pre-labelling: an optional ONNX detector suggests boxes for displayed
+    // frames on its own thread; suggestions are drawn dotted and can be
+    // accepted as tracks (Y) or saved with frames as they are
+    Prelabeler prelabeler_;
+    QString prelabelModel_;
+    QHash<int, std::vector<Annotation>> suggestions_;  // current video, by frame
+    bool saveSuggestions_ = false;
+    QAction *saveSuggestionsAction_ = nullptr;
+    void choosePrelabelModel();
+    void setPrelabelModel(const QString &path);
+    void requestSuggestions(int frame, cv::Size fullSize);
+    void onSuggestions(const QString &videoPath, int frame, const std::vector<Annotation> &boxes);
+    void acceptSuggestions();
+    std::vector<Annotation> suggestionsToSave(int frame);  // none unless enabled; registers their labels
+
+    // Burst capture ('B'): every stride-th frame in [current - radius, current + radius],
+    // decoded once sequentially and handed to the encoder pool
+    int burstRadius_ = 15;
+    int burstStride_ = 1;
+    QFuture<void> burstFuture_;
+    std::shared_ptr<std::atomic_bool> burstCancel_;
+    void startBurst();
+    void promptBurstSettings();
+    void onBurstFrameSaved(bool ok, const QString &videoPath, const QString &fileName);
+    void releaseReservedSaves(int count);
+
+    // Performance HUD ('H'): rolling per-stage timings over the video + status bar
+    QLabel *hudLabel_ = nullptr;
+    QLabel *hudStatus_ = nullptr;
+    QAction *hudAction_ = nullptr;
+    QTimer hudTimer_;
+    bool hudEnabled_ = false;
+    bool inVideoPaint_ = false;
+    void setupViewMenu();
+    void setHudVisible(bool on);
+    void refreshHud();
 
     // Shortcuts
     QShortcut *saveShortcut_ = nullptr;
 
-    // Frame cache
-    cv::Mat currentFrameBGR_;
+    // Frame on screen (native pictures get BGR only when saved)
+    DecodedFrame currentFrame_;
+    QImage displayImage_;               // display-size RGB32, rewritten in place
+    QPixmap framePixmap_;               // displayImage_ as shown, before overlays
+    void refreshOverlay();              // ROI + annotations over framePixmap_, no re-conversion
 
     // Config (simple txt)
-    QString configPath_;
     void loadConfig();
-    void saveConfig() const;
+    void saveConfig();
 
     // UI Beatifulization
     // flash "Next image" label after save
@@ -91,17 +299,17 @@ private:
     // Helpers
     void togglePlayPause();
     void openVideo(const QString &path);
-    void updateTimerFromFPS();
+    void scheduleNextTick();
     void updateInfoLabels();
-    void displayMat(const cv::Mat &bgr);
+    void displayFrame(const DecodedFrame &f);
     void ensureSliderRange();
     void seekTo(int frameIndex);
+    void seekToPts(double ptsMs);
     void stepRelative(int deltaFrames);
+    void showFrame(const DecodedFrame &f);
     void setPlaying(bool on);
-    void recalcNextImageFromDir();
-    static int extractLargestNumberInDir(const QString &dirPath);
     void saveCurrentFrame();
-    static QImage matToQImage(const cv::Mat &bgr);
+    void onFrameSaved(bool ok, const QString &videoPath, const QString &fileName, int imageIndex);  // 0: content name
 };
 
 #endif // MAINWINDOW_H
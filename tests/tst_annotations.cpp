@@ -0,0 +1,95 @@
+#include <QDir>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "annotations.h"
+
+class TestAnnotations : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void keyframeIsExact()
+    {
+        AnnotationSet set;
+        const int t = set.addTrack("car");
+        set.setKey(t, 10, cv::Rect2d(0, 0, 10, 10));
+        const std::vector<Annotation> a = set.at(10);
+        QCOMPARE(a.size(), size_t(1));
+        QCOMPARE(a[0].track, t);
+        QCOMPARE(a[0].label, QString("car"));
+        QVERIFY(a[0].keyframe);
+        QCOMPARE(a[0].box, cv::Rect2d(0, 0, 10, 10));
+    }
+
+    void interpolatesBetweenKeys()
+    {
+        AnnotationSet set;
+        const int t = set.addTrack("car");
+        set.setKey(t, 10, cv::Rect2d(0, 0, 10, 10));
+        set.setKey(t, 20, cv::Rect2d(100, 50, 30, 20));
+        const std::vector<Annotation> a = set.at(15);
+        QCOMPARE(a.size(), size_t(1));
+        QVERIFY(!a[0].keyframe);
+        QCOMPARE(a[0].box, cv::Rect2d(50, 25, 20, 15));
+    }
+
+    void nothingOutsideKeys()
+    {
+        AnnotationSet set;
+        const int t = set.addTrack("car");
+        set.setKey(t, 10, cv::Rect2d(0, 0, 10, 10));
+        set.setKey(t, 20, cv::Rect2d(10, 0, 10, 10));
+        QVERIFY(set.at(9).empty());
+        QVERIFY(set.at(21).empty());
+    }
+
+    void removingLastKeyRemovesTrack()
+    {
+        AnnotationSet set;
+        const int t = set.addTrack("car");
+        set.setKey(t, 10, cv::Rect2d(0, 0, 10, 10));
+        QVERIFY(set.removeKey(t, 10));
+        QVERIFY(!set.hasTrack(t));
+        QVERIFY(set.isEmpty());
+    }
+
+    void drawnKeyReplacesTrackedOne()
+    {
+        AnnotationSet set;
+        const int t = set.addTrack("car");
+        set.setTrackedKey(t, 5, cv::Rect2d(0, 0, 10, 10));
+        QVERIFY(set.hasKey(t, 5));
+        QVERIFY(!set.hasDrawnKey(t, 5));
+        set.setKey(t, 5, cv::Rect2d(1, 1, 10, 10));
+        QVERIFY(set.hasDrawnKey(t, 5));
+    }
+
+    void saveAndLoad()
+    {
+        QTemporaryDir tmp;
+        const QString file = QDir(tmp.path()).filePath("annotations.json");
+        AnnotationSet set;
+        const int car = set.addTrack("car");
+        set.setKey(car, 0, cv::Rect2d(0, 0, 10, 10));
+        set.setTrackedKey(car, 8, cv::Rect2d(8, 0, 10, 10));
+        const int point = set.addTrack("eye");
+        set.setKey(point, 3, cv::Rect2d(5, 5, 0, 0));
+        QVERIFY(set.save(file));
+
+        AnnotationSet loaded;
+        QVERIFY(loaded.load(file));
+        QCOMPARE(loaded.labelOf(car), QString("car"));
+        QCOMPARE(loaded.keyFrames(car), (std::vector<int>{0, 8}));
+        QVERIFY(loaded.hasDrawnKey(car, 0));
+        QVERIFY(!loaded.hasDrawnKey(car, 8));
+        QVERIFY(loaded.isPointTrack(point));
+        QCOMPARE(loaded.at(4).size(), size_t(1));
+        QCOMPARE(loaded.at(4)[0].box, cv::Rect2d(4, 0, 10, 10));
+        // New tracks continue after the loaded ids
+        QVERIFY(loaded.addTrack("dog") > point);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestAnnotations)
+#include "tst_annotations.moc"
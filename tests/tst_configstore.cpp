@@ -0,0 +1,86 @@
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "configstore.h"
+
+class TestConfigStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void saveAndLoad()
+    {
+        QTemporaryDir dir;
+        const QString path = dir.filePath("config.txt");
+        {
+            ConfigStore c;
+            c.setPath(path);
+            c.setValue("save_dir", "/data/out");
+            c.setValue("burst_radius", 15);
+            c.setValue("labels", "car|person");
+            QVERIFY(c.save());
+        }
+
+        ConfigStore c;
+        c.setPath(path);
+        QVERIFY(c.load());
+        QCOMPARE(c.value("save_dir"), QString("/data/out"));
+        QCOMPARE(c.intValue("burst_radius"), 15);
+        QCOMPARE(c.value("labels"), QString("car|person"));
+        QVERIFY(!c.contains("missing"));
+        QCOMPARE(c.value("missing", "def"), QString("def"));
+        QCOMPARE(c.intValue("save_dir", 7), 7);     // not a number
+    }
+
+    void parsesCommentsAndBlankLines()
+    {
+        QTemporaryDir dir;
+        QFile f(dir.filePath("config.txt"));
+        QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Text));
+        f.write("# comment\n\n  key = value with = sign \nbroken line\n=nokey\n");
+        f.close();
+
+        ConfigStore c;
+        c.setPath(f.fileName());
+        QVERIFY(c.load());
+        QCOMPARE(c.value("key"), QString("value with = sign"));
+        QVERIFY(!c.contains("broken line"));
+    }
+
+    void setValueReplaces()
+    {
+        ConfigStore c;
+        c.setValue("a", "1");
+        c.setValue("a", "2");
+        QCOMPARE(c.value("a"), QString("2"));
+    }
+
+    void saveLaterIsWrittenByFlush()
+    {
+        QTemporaryDir dir;
+        const QString path = dir.filePath("config.txt");
+        ConfigStore c;
+        c.setPath(path);
+        c.setValue("x", 1);
+        c.saveLater();
+        c.setValue("x", 2);
+        c.saveLater();
+        c.flush();
+
+        ConfigStore d;
+        d.setPath(path);
+        QVERIFY(d.load());
+        QCOMPARE(d.intValue("x"), 2);
+    }
+
+    void missingFileDoesNotLoad()
+    {
+        ConfigStore c;
+        c.setPath("/nonexistent/dir/config.txt");
+        QVERIFY(!c.load());
+    }
+};
+
+QTEST_GUILESS_MAIN(TestConfigStore)
+#include "tst_configstore.moc"
@@ -0,0 +1,257 @@
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QSet>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "datasetindex.h"
+
+namespace {
+
+// Child process mode: reserve `times` blocks of `count`, print each first index
+int runWorker(const QString &dir, int times, int count)
+{
+    DatasetIndex index;
+    index.setDirectory(dir);
+    for (int i = 0; i < times; ++i)
+    {
+        const int first = index.reserve(count);
+        if (first < 0) return 1;
+        std::printf("%d\n", first);
+        index.release(count);
+    }
+    std::fflush(stdout);
+    return 0;
+}
+
+} // namespace
+
+class TestDatasetIndex : public QObject
+{
+    Q_OBJECT
+
+private:
+    static constexpr int kWorkers = 4;
+    static constexpr int kTimes = 50;
+    static constexpr int kCount = 3;
+
+    static void touch(const QString &path, const QByteArray &data = QByteArray())
+    {
+        QFile f(path);
+        QVERIFY(f.open(QIODevice::WriteOnly));
+        f.write(data);
+    }
+
+    // Runs kWorkers processes against dir; their first indices, per worker
+    static QList<QList<int>> runWorkers(const QString &dir)
+    {
+        QList<QProcess *> procs;
+        for (int w = 0; w < kWorkers; ++w)
+        {
+            auto *p = new QProcess;
+            p->start(QCoreApplication::applicationFilePath(),
+                     {"worker", dir, QString::number(kTimes), QString::number(kCount)});
+            procs << p;
+        }
+        QList<QList<int>> firsts;
+        for (QProcess *p : procs)
+        {
+            p->waitForFinished(60000);
+            QList<int> mine;
+            if (p->exitStatus() == QProcess::NormalExit && p->exitCode() == 0)
+                for (const QByteArray &line : p->readAllStandardOutput().split('\n'))
+                    if (!line.isEmpty()) mine << line.toInt();
+            firsts << mine;
+            delete p;
+        }
+        return firsts;
+    }
+
+    static void verifyUniqueAndLeased(const QList<QList<int>> &firsts)
+    {
+        QSet<int> taken;
+        for (const QList<int> &mine : firsts)
+        {
+            QCOMPARE(mine.size(), kTimes);
+            int run = 1;
+            for (int i = 0; i < mine.size(); ++i)
+            {
+                for (int n = mine[i]; n < mine[i] + kCount; ++n)
+                {
+                    QVERIFY2(!taken.contains(n), qPrintable(QString("index %1 handed out twice").arg(n)));
+                    taken.insert(n);
+                }
+                if (i == 0) continue;
+                QVERIFY(mine[i] > mine[i - 1]);
+                if (mine[i] == mine[i - 1] + kCount)
+                {
+                    ++run;
+                    continue;
+                }
+                // A new lease only once the last one had no room left
+                QCOMPARE(run, DatasetIndex::kLeaseBlock / kCount);
+                run = 1;
+            }
+        }
+    }
+
+private slots:
+    void continuesAfterExistingFiles()
+    {
+        QTemporaryDir dir;
+        touch(dir.filePath("image_0007.png"));
+        touch(dir.filePath("image_0012.png"));
+        touch(dir.filePath("notes.txt"));
+
+        DatasetIndex index;
+        index.setDirectory(dir.path());
+        QCOMPARE(index.nextIndex(), 13);
+        QCOMPARE(index.reserve(), 13);
+        QCOMPARE(index.pending(), 1);
+    }
+
+    void largestNumberInShards()
+    {
+        QTemporaryDir dir;
+        QDir d(dir.path());
+        // Numeric folders that are not shards, and an empty top shard
+        QVERIFY(d.mkpath("2023") && d.mkpath("37") && d.mkpath("0002") && d.mkpath("0001"));
+        touch(d.filePath("2023/image_9999.png"));
+        touch(d.filePath("37/37ab12.png"));
+        touch(d.filePath("0001/image_1234.png"));
+        QCOMPARE(DatasetIndex::largestNumberIn(dir.path()), 1234);
+    }
+
+    void reserveAndRelease()
+    {
+        QTemporaryDir dir;
+        DatasetIndex index;
+        index.setDirectory(dir.path());
+
+        const int a = index.reserve(5);
+        QCOMPARE(a, 1);
+        QCOMPARE(index.reserve(), 6);       // burst numbers stay contiguous
+        QCOMPARE(index.pending(), 6);
+
+        index.release(5);
+        QCOMPARE(index.pending(), 1);
+        index.rescan();                     // a reservation is outstanding: no effect
+        QCOMPARE(index.nextIndex(), 7);
+        index.release(3);                   // never below zero
+        QCOMPARE(index.pending(), 0);
+    }
+
+    void secondIndexDoesNotReuseNumbers()
+    {
+        QTemporaryDir dir;
+        DatasetIndex first;
+        DatasetIndex second;
+        first.setDirectory(dir.path());
+        second.setDirectory(dir.path());
+
+        const int a = first.reserve();
+        const int b = second.reserve();
+        QVERIFY(a != b);
+        QVERIFY(b >= a + DatasetIndex::kLeaseBlock);
+    }
+
+    void concurrentProcesses()
+    {
+        QTemporaryDir dir;
+        touch(dir.filePath("image_0100.png"));
+        const QList<QList<int>> firsts = runWorkers(dir.path());
+        verifyUniqueAndLeased(firsts);
+        for (const QList<int> &mine : firsts)
+            QVERIFY(!mine.isEmpty() && mine.first() > 100);
+    }
+
+    void staleLockOfDeadProcess()
+    {
+        QTemporaryDir dir;
+        QProcess p;
+        p.start(QCoreApplication::applicationFilePath(), {"worker", dir.path(), "0", "1"});
+        QVERIFY(p.waitForStarted());
+        const qint64 pid = p.processId();
+        QVERIFY(p.waitForFinished());
+
+        // Left behind by a process of this machine that no longer runs
+        touch(dir.filePath(".vdt_index.lock"),
+              QString("%1 %2 dead\n").arg(QSysInfo::machineHostName().remove(' ')).arg(pid).toUtf8());
+        DatasetIndex index;
+        index.setDirectory(dir.path());
+        QElapsedTimer t;
+        t.start();
+        QCOMPARE(index.reserve(), 1);
+        QVERIFY(t.elapsed() < DatasetIndex::kStaleLockMs);
+        QVERIFY(!QFile::exists(dir.filePath(".vdt_index.lock")));
+    }
+
+    void staleLockOfOtherHostWithWaiters()
+    {
+        QTemporaryDir dir;
+        // Only its age tells: every worker watches it, one breaks it
+        touch(dir.filePath(".vdt_index.lock"), "otherhost 1 stale\n");
+        QElapsedTimer t;
+        t.start();
+        verifyUniqueAndLeased(runWorkers(dir.path()));
+        QVERIFY(t.elapsed() >= DatasetIndex::kStaleLockMs);
+        QVERIFY(!QFile::exists(dir.filePath(".vdt_index.lock")));
+        QVERIFY(!QFile::exists(dir.filePath(".vdt_index.lock.break")));
+    }
+
+    void readOnlyDirectoryFailsFast()
+    {
+        QTemporaryDir dir;
+        QFile::setPermissions(dir.path(), QFile::ReadOwner | QFile::ExeOwner);
+        DatasetIndex index;
+        index.setDirectory(dir.path());
+        if (index.isWritable())
+        {
+            QFile::setPermissions(dir.path(), QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+            QSKIP("permissions are not enforced for this user");
+        }
+        QElapsedTimer t;
+        t.start();
+        QCOMPARE(index.reserve(), -1);
+        QVERIFY(t.elapsed() < 1000);
+        QFile::setPermissions(dir.path(), QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    }
+
+    void mergeClassesKeepsIds()
+    {
+        QTemporaryDir dir;
+        touch(dir.filePath("classes.txt"), "car\nperson\n");
+        QStringList classes = {"dog", "car"};
+        QVERIFY(DatasetIndex::mergeClasses(dir.path(), classes));
+        QCOMPARE(classes, QStringList({"car", "person", "dog"}));
+        QStringList again = {"person"};
+        QVERIFY(DatasetIndex::mergeClasses(dir.path(), again));
+        QCOMPARE(again, classes);
+        QFile f(dir.filePath("classes.txt"));
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        QCOMPARE(f.readAll(), QByteArray("car\nperson\ndog\n"));
+        QVERIFY(!QFile::exists(dir.filePath(".vdt_index.lock")));
+    }
+
+    void fileNames()
+    {
+        QCOMPARE(DatasetIndex::fileNameFor(42), QString("image_0042.png"));
+        QCOMPARE(DatasetIndex::fileNameFor(123456), QString("image_123456.png"));
+    }
+};
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    if (argc == 5 && qstrcmp(argv[1], "worker") == 0)
+        return runWorker(QString::fromLocal8Bit(argv[2]), atoi(argv[3]), atoi(argv[4]));
+    TestDatasetIndex t;
+    return QTest::qExec(&t, argc, argv);
+}
+
+#include "tst_datasetindex.moc"
@@ -0,0 +1,71 @@
+#include <QtTest>
+
+#include "framecache.h"
+
+class TestFrameCache : public QObject
+{
+    Q_OBJECT
+
+private:
+    static constexpr size_t kFrameBytes = 64 * 48 * 3;
+
+    static DecodedFrame frame(int index)
+    {
+        DecodedFrame f;
+        f.bgr = cv::Mat(48, 64, CV_8UC3, cv::Scalar(index, 0, 0));
+        f.index = index;
+        return f;
+    }
+
+private slots:
+    void evictsLeastRecentlyUsed()
+    {
+        FrameCache cache(3 * kFrameBytes);
+        for (int i = 0; i < 3; ++i) cache.put(frame(i));
+        QCOMPARE(cache.bytes(), 3 * kFrameBytes);
+
+        DecodedFrame out;
+        QVERIFY(cache.get(0, out));         // 0 is now the most recent
+        QCOMPARE(out.index, 0);
+
+        cache.put(frame(3));
+        QCOMPARE(cache.bytes(), 3 * kFrameBytes);
+        QVERIFY(!cache.get(1, out));        // oldest after the get()
+        QVERIFY(cache.get(0, out));
+        QVERIFY(cache.get(2, out));
+        QVERIFY(cache.get(3, out));
+    }
+
+    void replacingKeepsByteCount()
+    {
+        FrameCache cache(10 * kFrameBytes);
+        cache.put(frame(5));
+        cache.put(frame(5));
+        QCOMPARE(cache.bytes(), kFrameBytes);
+    }
+
+    void shrinkingBudgetEvicts()
+    {
+        FrameCache cache(4 * kFrameBytes);
+        for (int i = 0; i < 4; ++i) cache.put(frame(i));
+        cache.setBudget(kFrameBytes);
+        QVERIFY(cache.bytes() <= kFrameBytes);
+        DecodedFrame out;
+        QVERIFY(cache.get(3, out));
+        QVERIFY(!cache.get(0, out));
+
+        cache.clear();
+        QCOMPARE(cache.bytes(), size_t(0));
+        QVERIFY(!cache.get(3, out));
+    }
+
+    void ignoresEmptyFrames()
+    {
+        FrameCache cache;
+        cache.put(DecodedFrame());
+        QCOMPARE(cache.bytes(), size_t(0));
+    }
+};
+
+QTEST_GUILESS_MAIN(TestFrameCache)
+#include "tst_framecache.moc"
@@ -0,0 +1,88 @@
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "progressstore.h"
+
+class TestProgressStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void replaysLatestState()
+    {
+        QTemporaryDir dir;
+        const QString log = dir.filePath("progress.jsonl");
+        {
+            ProgressStore s;
+            QVERIFY(s.open(log));
+            s.setPosition("/videos/a.mp4", 10, 400.0);
+            s.setPosition("/videos/a.mp4", 25, 1000.0);
+            s.addSaved("/videos/a.mp4", 3);
+            s.setDone("/videos/b.mp4", true);
+        }
+
+        ProgressStore s;
+        QVERIFY(s.open(log));
+        QCOMPARE(s.count(), 2);
+        QCOMPARE(s.doneCount(), 1);
+        const VideoProgress a = s.get("/videos/a.mp4");
+        QCOMPARE(a.lastFrame, 25);
+        QCOMPARE(a.lastPtsMs, 1000.0);
+        QCOMPARE(a.savedFrames, 3);
+        QVERIFY(!a.done);
+        QVERIFY(s.get("/videos/b.mp4").done);
+        QVERIFY(!s.contains("/videos/c.mp4"));
+    }
+
+    void tornLineIsCutBeforeAppending()
+    {
+        QTemporaryDir dir;
+        const QString log = dir.filePath("progress.jsonl");
+        {
+            ProgressStore s;
+            QVERIFY(s.open(log));
+            s.setPosition("/videos/a.mp4", 5, 200.0);
+        }
+        {
+            // Crash in the middle of the next record
+            QFile f(log);
+            QVERIFY(f.open(QIODevice::Append));
+            f.write("{\"video\":\"/videos/a.mp4\",\"fra");
+        }
+        {
+            ProgressStore s;
+            QVERIFY(s.open(log));
+            QCOMPARE(s.get("/videos/a.mp4").lastFrame, 5);
+            s.setPosition("/videos/a.mp4", 9, 360.0);
+        }
+
+        ProgressStore s;
+        QVERIFY(s.open(log));
+        QCOMPARE(s.get("/videos/a.mp4").lastFrame, 9);
+    }
+
+    void compactKeepsState()
+    {
+        QTemporaryDir dir;
+        const QString log = dir.filePath("progress.jsonl");
+        ProgressStore s;
+        QVERIFY(s.open(log));
+        for (int i = 1; i <= 50; ++i) s.setPosition("/videos/a.mp4", i, i * 40.0);
+        s.setDone("/videos/a.mp4", true);
+        QVERIFY(s.compact());
+        s.close();
+
+        QFile f(log);
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        QCOMPARE(f.readAll().count('\n'), 1);
+
+        ProgressStore t;
+        QVERIFY(t.open(log));
+        QCOMPARE(t.get("/videos/a.mp4").lastFrame, 50);
+        QVERIFY(t.get("/videos/a.mp4").done);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestProgressStore)
+#include "tst_progressstore.moc"
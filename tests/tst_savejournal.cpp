@@ -0,0 +1,205 @@
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QProcess>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "savejournal.h"
+
+class TestSaveJournal : public QObject
+{
+    Q_OBJECT
+
+private:
+    static void write(const QString &path, const QByteArray &data = "x")
+    {
+        QFile f(path);
+        QVERIFY(f.open(QIODevice::WriteOnly));
+        f.write(data);
+    }
+
+    // Looks like a crashed session's: older than SaveJournal::kStaleMs
+    static void age(const QString &path)
+    {
+        QFile f(path);
+        QVERIFY(f.open(QIODevice::ReadWrite));
+        QVERIFY(f.setFileTime(QDateTime::currentDateTime().addSecs(-600), QFileDevice::FileModificationTime));
+    }
+
+private slots:
+    void recoverRemovesUncommittedSaves()
+    {
+        QTemporaryDir tmp;
+        QDir dir(tmp.path());
+        QVERIFY(dir.mkpath("320px"));
+        write(dir.filePath("image_0001.png"));
+        write(dir.filePath("image_0002.png"));
+        write(dir.filePath("320px/image_0002.png"));
+        write(dir.filePath("image_0002.txt"));
+        write(dir.filePath("image_0003.png.part"));
+        age(dir.filePath("image_0003.png.part"));
+
+        const QString journal = dir.filePath(".vdt_journal-otherhost-1");
+        write(journal, "B image_0001.png\nC image_0001.png\nB image_0002.png\nC");
+        age(journal);
+
+        const SaveJournal::Recovery r = SaveJournal::recover(dir.path());
+        QCOMPARE(r.removedSaves, 1);
+        QCOMPARE(r.removedParts, 1);
+        QVERIFY(dir.exists("image_0001.png"));
+        QVERIFY(!dir.exists("image_0002.png"));
+        QVERIFY(!dir.exists("320px/image_0002.png"));
+        QVERIFY(!dir.exists("image_0002.txt"));
+        QVERIFY(!dir.exists("image_0003.png.part"));
+        QVERIFY(!QFile::exists(journal));
+    }
+
+    void recoverRemovesPartsInShards()
+    {
+        QTemporaryDir tmp;
+        QDir dir(tmp.path());
+        QVERIFY(dir.mkpath("0012") && dir.mkpath("640px/0012"));
+        const QString stale = "0012/image_12001.png.1f.part";
+        const QString staleLevel = "640px/0012/image_12001.png.2e.part";
+        for (const QString &p : {stale, staleLevel})
+        {
+            write(dir.filePath(p));
+            age(dir.filePath(p));
+        }
+
+        const SaveJournal::Recovery r = SaveJournal::recover(dir.path());
+        QCOMPARE(r.removedParts, 2);
+        QVERIFY(!dir.exists(stale));
+        QVERIFY(!dir.exists(staleLevel));
+    }
+
+    void recoverRemovesPartsInContentFolders()
+    {
+        QTemporaryDir tmp;
+        QDir dir(tmp.path());
+        QVERIFY(dir.mkpath("ab/cd") && dir.mkpath("320px/ab/cd"));
+        const QString stale = "ab/cd/abcd01.png.1f.part";
+        const QString staleLevel = "320px/ab/cd/abcd01.png.2e.part";
+        const QString fresh = "ab/cd/abcd02.png.3d.part";
+        for (const QString &p : {stale, staleLevel, fresh}) write(dir.filePath(p));
+        age(dir.filePath(stale));
+        age(dir.filePath(staleLevel));
+
+        const SaveJournal::Recovery r = SaveJournal::recover(dir.path());
+        QCOMPARE(r.removedParts, 2);
+        QVERIFY(!dir.exists(stale));
+        QVERIFY(!dir.exists(staleLevel));
+        QVERIFY(dir.exists(fresh));
+    }
+
+    void recoverLeavesLiveSessionsAlone()
+    {
+        QTemporaryDir tmp;
+        QDir dir(tmp.path());
+        write(dir.filePath("image_0005.png"));
+        write(dir.filePath("image_0006.png.part"));
+        const QString journal = dir.filePath(".vdt_journal-otherhost-2");
+        write(journal, "B image_0005.png\n");
+
+        const SaveJournal::Recovery r = SaveJournal::recover(dir.path());
+        QCOMPARE(r.removedSaves, 0);
+        QCOMPARE(r.removedParts, 0);
+        QVERIFY(dir.exists("image_0005.png"));
+        QVERIFY(dir.exists("image_0006.png.part"));
+        QVERIFY(QFile::exists(journal));
+    }
+
+    void recoverJudgesLocalSessionsByProcess()
+    {
+        QTemporaryDir tmp;
+        QDir dir(tmp.path());
+        const QString host = QSysInfo::machineHostName();
+
+        // Idle for long, but its process (init / System) still runs
+#ifdef Q_OS_WIN
+        const qint64 alive = 4;
+#else
+        const qint64 alive = 1;
+#endif
+        write(dir.filePath("image_0011.png"));
+        const QString live = dir.filePath(QString(".vdt_journal-%1-%2").arg(host).arg(alive));
+        write(live, "B image_0011.png\n");
+        age(live);
+
+        // Written just now by a process that is gone
+        QProcess p;
+        p.start(QCoreApplication::applicationFilePath(), {"-functions"});
+        QVERIFY(p.waitForStarted());
+        const qint64 pid = p.processId();
+        QVERIFY(p.waitForFinished());
+        write(dir.filePath("image_0012.png"));
+        const QString dead = dir.filePath(QString(".vdt_journal-%1-%2").arg(host).arg(pid));
+        write(dead, "B image_0012.png\n");
+
+        const SaveJournal::Recovery r = SaveJournal::recover(dir.path());
+        QCOMPARE(r.removedSaves, 1);
+        QVERIFY(dir.exists("image_0011.png"));
+        QVERIFY(QFile::exists(live));
+        QVERIFY(!dir.exists("image_0012.png"));
+        QVERIFY(!QFile::exists(dead));
+    }
+
+    void abortRemovesWrittenFiles()
+    {
+        QTemporaryDir tmp;
+        QDir dir(tmp.path());
+        SaveJournal journal;
+        QVERIFY(journal.begin(dir.path(), "image_0007.png"));
+        QVERIFY(SaveJournal::writeAndSync(dir.filePath("image_0007.png"), "png", 3));
+        QVERIFY(dir.exists("image_0007.png"));
+        journal.abort(dir.path(), "image_0007.png");
+        QVERIFY(!dir.exists("image_0007.png"));
+    }
+
+    void writeAndSyncReplaces()
+    {
+        QTemporaryDir tmp;
+        const QString path = QDir(tmp.path()).filePath("image_0008.png");
+        QVERIFY(SaveJournal::writeAndSync(path, "old", 3));
+        QVERIFY(SaveJournal::writeAndSync(path, "newer", 5));
+        QFile f(path);
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        QCOMPARE(f.readAll(), QByteArray("newer"));
+        QCOMPARE(QDir(tmp.path()).entryList({"*.part"}, QDir::Files).size(), 0);
+    }
+
+    void keepExistingNeverReplaces()
+    {
+        QTemporaryDir tmp;
+        const QString path = QDir(tmp.path()).filePath("abcdef.png");
+        QVERIFY(SaveJournal::writeAndSync(path, "first", 5, true));
+        QVERIFY(SaveJournal::writeAndSync(path, "second", 6, true));
+        QFile f(path);
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        QCOMPARE(f.readAll(), QByteArray("first"));
+        QCOMPARE(QDir(tmp.path()).entryList({"*.part"}, QDir::Files).size(), 0);
+    }
+
+    void partNamesAreUnique()
+    {
+        const QString a = SaveJournal::partPathFor("image_0009.png");
+        QVERIFY(a.startsWith("image_0009.png.") && a.endsWith(".part"));
+        QVERIFY(a != SaveJournal::partPathFor("image_0009.png"));
+    }
+
+    void abortRemovesOwnParts()
+    {
+        QTemporaryDir tmp;
+        QDir dir(tmp.path());
+        SaveJournal journal;
+        QVERIFY(journal.begin(dir.path(), "image_0010.png"));
+        write(SaveJournal::partPathFor(dir.filePath("image_0010.png")));
+        journal.abort(dir.path(), "image_0010.png");
+        QCOMPARE(dir.entryList({"*.part"}, QDir::Files).size(), 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestSaveJournal)
+#include "tst_savejournal.moc"
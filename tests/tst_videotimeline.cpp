@@ -0,0 +1,83 @@
+#include <QDataStream>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "videotimeline.h"
+
+class TestVideoTimeline : public QObject
+{
+    Q_OBJECT
+
+private:
+    // A scanned (exact) table with these timestamps, via the cache format
+    static VideoTimeline exactTable(const QString &file, const std::vector<double> &pts)
+    {
+        QSaveFile f(file);
+        if (!f.open(QIODevice::WriteOnly)) return VideoTimeline();
+        QDataStream out(&f);
+        out << quint32(0x56445454) << quint32(1) << 40.0 << quint32(pts.size());
+        for (double p : pts) out << p;
+        f.commit();
+        return VideoTimeline::load(file);
+    }
+
+private slots:
+    void constantRate()
+    {
+        const VideoTimeline t = VideoTimeline::fromConstantRate(10, 25.0);
+        QCOMPARE(t.frameCount(), 10);
+        QVERIFY(!t.isExact());
+        QCOMPARE(t.indexAt(0.0), 0);
+        QCOMPARE(t.indexAt(39.0), 0);
+        QCOMPARE(t.indexAt(40.0), 1);
+        QCOMPARE(t.indexAt(39.7), 1);       // float round-trip tolerance
+        QCOMPARE(t.indexAt(-100.0), 0);
+        QCOMPARE(t.indexAt(1e9), 9);
+        QCOMPARE(t.ptsAt(3), 120.0);
+    }
+
+    void variableRate()
+    {
+        QTemporaryDir dir;
+        const VideoTimeline t = exactTable(dir.filePath("vfr.pts"), {0.0, 10.0, 50.0, 60.0});
+        QVERIFY(t.isExact());
+        QCOMPARE(t.frameCount(), 4);
+        QCOMPARE(t.indexAt(9.0), 0);
+        QCOMPARE(t.indexAt(10.0), 1);
+        QCOMPARE(t.indexAt(49.0), 1);
+        QCOMPARE(t.indexAt(50.0), 2);
+        QCOMPARE(t.indexAt(75.0), 3);
+        QCOMPARE(t.frameDurationAt(1), 40.0);
+        QCOMPARE(t.durationMs(), 100.0);
+    }
+
+    void indexAtInvertsPtsAt()
+    {
+        QTemporaryDir dir;
+        const VideoTimeline t = exactTable(dir.filePath("vfr.pts"), {0.0, 33.3, 66.7, 100.0, 166.7, 200.0});
+        for (int i = 0; i < t.frameCount(); ++i)
+            QCOMPARE(t.indexAt(t.ptsAt(i)), i);
+    }
+
+    void saveLoadRoundTrip()
+    {
+        QTemporaryDir dir;
+        const VideoTimeline t = exactTable(dir.filePath("a.pts"), {0.0, 20.0, 45.0});
+        QVERIFY(t.save(dir.filePath("b.pts")));
+        const VideoTimeline u = VideoTimeline::load(dir.filePath("b.pts"));
+        QCOMPARE(u.frameCount(), 3);
+        QCOMPARE(u.ptsAt(2), 45.0);
+
+        // Estimates are not cached; garbage does not load
+        QVERIFY(!VideoTimeline::fromConstantRate(5, 30.0).save(dir.filePath("c.pts")));
+        QFile junk(dir.filePath("junk.pts"));
+        QVERIFY(junk.open(QIODevice::WriteOnly));
+        junk.write("not a timeline");
+        junk.close();
+        QVERIFY(VideoTimeline::load(junk.fileName()).isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(TestVideoTimeline)
+#include "tst_videotimeline.moc"